@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -39,7 +39,21 @@ SOURCES += \
     src/bfsalgorithm.cpp \
     src/raport.cpp \
     src/dfsalgorithm.cpp \
-    src/dejikstralgorithm.cpp
+    src/dejikstralgorithm.cpp \
+    src/csrgraph.cpp \
+    src/graphmodel.cpp \
+    src/heap.cpp \
+    src/astaralgorithm.cpp \
+    src/epocharray.cpp \
+    src/wayarena.cpp \
+    src/allpairs.cpp \
+    src/batchalgorithm.cpp \
+    src/dynamictree.cpp \
+    src/contractionhierarchy.cpp \
+    src/landmarks.cpp \
+    src/resultcache.cpp \
+    src/graphfile.cpp \
+    src/graphtext.cpp
 
 HEADERS += \
         include/mainwindow.h \
@@ -55,4 +69,18 @@ HEADERS += \
     include/bfsalgorithm.h \
     include/raport.h \
     include/dfsalgorithm.h \
-    include/dejikstralgorithm.h
+    include/dejikstralgorithm.h \
+    include/csrgraph.h \
+    include/graphmodel.h \
+    include/heap.h \
+    include/astaralgorithm.h \
+    include/epocharray.h \
+    include/wayarena.h \
+    include/allpairs.h \
+    include/batchalgorithm.h \
+    include/dynamictree.h \
+    include/contractionhierarchy.h \
+    include/landmarks.h \
+    include/resultcache.h \
+    include/graphfile.h \
+    include/graphtext.h
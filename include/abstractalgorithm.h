@@ -3,15 +3,22 @@
 
 #include <QObject>
 #include <QVector>
-#include <QList>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 
 #include <climits>
 #include "mainwindow.h"
+#include "csrgraph.h"
+#include "epocharray.h"
+#include "wayarena.h"
+#include "resultcache.h"
 
 #define INF INT32_MAX
 
 class GraphicsView;
 class Node;
+class Tab;
 
 typedef struct
 {
@@ -20,51 +27,116 @@ typedef struct
 } code2color_t;
 
 
-struct Vertex
-{
-    int id;
-    bool visited;
-    QVector<int> visited_from;
-
-    Vertex(int _id, bool _visited) :
-        id (_id),
-        visited(_visited)
-    { }
-};
-
 class AbstractAlgorithm : public QObject
 {
     Q_OBJECT
 
+    enum
+    {
+      PollSteps = 1024, /* Steps between cancel/budget checks */
+      PaintBatch = 256 /* Nodes coloured per GUI event loop pass */
+    };
+
 public:
      explicit AbstractAlgorithm(QObject *parent = Q_NULLPTR);
      ~AbstractAlgorithm();
-     void initGraph();
-     QVector<QVector<int> > getGraph() const;
+     /* XXX: Snapshot of the model graph, run() takes it before a search */
+     virtual void initGraph();
+     void setGraph(const CSRGraph &graph);
+     void setPositions(const QVector<QPointF> &positions);
+     const CSRGraph &getGraph() const;
+     /* XXX: Works on the graph model only, no scene items involved */
+     bool execute(int start, int finish, bool order);
+     QVector<int> getOpened() const;
+     QVector<QVector<int> > getWays() const;
+     void setBidirectional(bool bidirectional);
+     int getExplored() const;
+     /* XXX: Time limit of execute() in ms, 0 - no limit */
+     void setTimeBudget(int msec);
+     bool isRunning() const;
+     bool isCancelled() const;
+     bool isTimedOut() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(int value, int maximum);
+    void stopped();
 
 private:
-    bool resizeGraph(GraphicsView *view);
     void debugGraph();
+    bool pushParents(const EpochArray &parent, int from, int to);
 
 protected:
-    virtual void algorithm(Node *start, Node *finish, GraphicsView *view,
-        bool order) = 0;
-    void checkBranch(QVector<int> &marked, Node *finish, GraphicsView *view);
-    QVector<int> markWay(GraphicsView *view, Node *finish, bool reset);
-    void markEdge(QVector<int> marked, Node *finish, GraphicsView *view, bool reset);
-    int getIndex(int val) const;
-    void clearWay();
+    /* XXX: Model version of m_graph, none for a graph given by setGraph() */
+    static const quint64 NoVersion = ~Q_UINT64_C(0);
+
+    virtual bool algorithm(int start, int finish, bool order) = 0;
+    virtual void apply(GraphicsView *view, int start);
+    virtual void configure(Tab *tab);
+    /* XXX: Endpoints of run(), marked start and finish nodes by default */
+    virtual bool select(GraphicsView *view, int *start, int *finish);
+    /* XXX: Result cache hooks. variant() adds settings to the key, save
+     * and load move what apply() needs in and out of a cache entry */
+    virtual bool cacheable() const;
+    virtual QString variant() const;
+    virtual void saveResult(algorithm_result_t *result) const;
+    virtual void loadResult(const algorithm_result_t &result);
+    /* XXX: Append a way found by parents to m_ways */
+    bool addWay(int start, int finish);
+    bool addMeetWay(int start, int from, int to, int finish);
+    /* XXX: Built on first use, kept until the graph changes */
+    const CSRGraph &reverseGraph();
+    quint64 graphVersion() const;
+    void markEdge(int index, GraphicsView *view, int code);
+    QVector<int> toNames(QVector<int> ids) const;
+    /* XXX: Call once per step of a search loop (or with the size of a
+     * whole level). Thread safe against cancel(), stays true once the
+     * search was stopped */
+    bool interrupted(int steps = 1);
+
+public slots:
+    void run();
 
 private slots:
-    void run();
+    void finished();
+    void paintOpened();
 
 protected:
-    QVector<QVector<int> > m_graph;
-    QList<int> m_list;
-    QVector<int> m_debug;
-    QVector<Vertex*> m_way;
+    CSRGraph m_graph;
+    /* XXX: Per run state lives in epoch arrays, they are reset in O(1)
+     * by execute(), so repeated runs on a big graph allocate nothing */
+    EpochArray m_parent;
     QVector<int> m_raport;
-    int *m_shortest;
+    WayArena m_ways;
+    EpochArray m_shortest;
+    /* XXX: Reverse adjacency and parents for the search from finish */
+    CSRGraph m_reverse;
+    EpochArray m_reverse_parent;
+    bool m_bidirectional;
+    int m_explored;
+    /* XXX: Scene coordinates of nodes, by id */
+    QVector<QPointF> m_positions;
+
+private:
+    QFutureWatcher<bool> m_watcher;
+    QAtomicInt m_cancel;
+    QElapsedTimer m_timer;
+    int m_budget;
+    int m_steps;
+    int m_next_poll;
+    bool m_stopped;
+    bool m_timed_out;
+    int m_start;
+    /* XXX: GUI copy of m_raport being painted, the worker of the next
+     * run refills m_raport meanwhile */
+    QVector<int> m_opened;
+    int m_painted;
+    bool m_paint_pending;
+    ResultCache m_cache;
+    cache_key_t m_key;
+    quint64 m_version;
 };
 
 extern code2color_t code2color_arr[];
@@ -0,0 +1,99 @@
+#ifndef ALLPAIRS_H
+#define ALLPAIRS_H
+
+#include <functional>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "csrgraph.h"
+#include "epocharray.h"
+#include "heap.h"
+
+/* XXX: Distance matrix file: matrix_header_t, then size * size qint32
+ * row-major, -1 where there is no way. Native byte order, the file is a
+ * scratch result for the Raport window, not an exchange format. */
+
+#define MATRIX_MAGIC "G2DM"
+#define MATRIX_VERSION 1
+
+typedef struct
+{
+    char magic[4];
+    qint32 version;
+    qint32 size;
+    qint32 reserved;
+} matrix_header_t;
+
+/* XXX: Sources handled by one task of the repeated Dejikstra */
+typedef struct
+{
+    int begin;
+    int end;
+    QVector<qint32> rows;
+    BinaryHeap heap;
+} apsp_chunk_t;
+
+class AllPairs
+{
+    enum
+    {
+        Tile = 64, /* Floyd-Warshall block side, 16KB of ints */
+        DenseRatio = 4, /* Dense when arcs * ratio >= size^2 */
+        FloydLimit = 4096, /* Bigger matrices don't stay in memory */
+        Batch = 256 /* Sources written per repeated Dejikstra round */
+    };
+
+public:
+    enum Method
+    {
+        Auto,
+        FloydWarshall,
+        RepeatedDejikstra
+    };
+
+    explicit AllPairs(const CSRGraph &graph);
+    ~AllPairs();
+
+    /* XXX: stop(steps) is polled between blocks, true aborts the run */
+    bool write(QString filename, Method method,
+      std::function<bool(int)> stop);
+    Method chosen() const;
+    static QString methodName(Method method);
+
+private:
+    Method choose() const;
+    bool writeHeader(QFile &file) const;
+    bool floydWarshall(QFile &file, std::function<bool(int)> stop);
+    void relaxTile(qint32 *dist, int ib, int jb, int kb) const;
+    bool repeatedDejikstra(QFile &file, std::function<bool(int)> stop);
+    void dejikstraRow(apsp_chunk_t &chunk, int source) const;
+
+private:
+    const CSRGraph &m_graph;
+    Method m_chosen;
+};
+
+/* XXX: Reads rows of a matrix file on demand, nothing is kept but the
+ * last row */
+class DistanceMatrix
+{
+public:
+    DistanceMatrix();
+    ~DistanceMatrix();
+
+    bool open(QString filename);
+    void close();
+    bool isOpen() const;
+    int size() const;
+    /* XXX: -1 - no way */
+    int distance(int from, int to);
+
+private:
+    QFile m_file;
+    int m_size;
+    int m_row_id;
+    QVector<qint32> m_row;
+};
+
+#endif // ALLPAIRS_H
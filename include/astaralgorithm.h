@@ -0,0 +1,71 @@
+#ifndef ASTARALGORITHM_H
+#define ASTARALGORITHM_H
+
+#include "abstractalgorithm.h"
+#include "heap.h"
+#include "landmarks.h"
+
+/* XXX: Heuristic is the straight distance between node centers, multiplied
+ * by scale. It is a lower bound only while scale * length <= weight holds
+ * for every arc, otherwise scale is lowered to the biggest safe value.
+ * With landmarks on, the ALT bound is taken where it is bigger, both are
+ * consistent, so their maximum is too. */
+
+class AStarAlgorithm : public AbstractAlgorithm
+{
+    Q_OBJECT
+
+public:
+     explicit AStarAlgorithm(QObject *parent = Q_NULLPTR);
+     ~AStarAlgorithm();
+     void setScale(double scale);
+     double admissibleScale() const;
+     /* XXX: Also count what plain Dejikstra expands, -1 if not asked */
+     void setCompare(bool compare);
+     int getDijkstraExplored() const;
+     /* XXX: count 0 - no landmarks */
+     void setLandmarks(int count, Landmarks::Selection selection);
+     /* XXX: Landmarks of the model graph, a file next to its graph file
+      * or a section of it. save() computes the tables first if the graph
+      * changed since. Another graph, the renumbered one of a graph file,
+      * gets tables of its own, the kept ones are left alone */
+     bool saveLandmarks(QIODevice *device, const CSRGraph *graph = nullptr);
+     bool loadLandmarks(QIODevice *device);
+
+protected:
+    virtual bool algorithm(int start, int finish, bool order);
+    virtual void apply(GraphicsView *view, int start);
+    virtual void configure(Tab *tab);
+    virtual QString variant() const;
+    virtual void saveResult(algorithm_result_t *result) const;
+    virtual void loadResult(const algorithm_result_t &result);
+
+private:
+    double length(int first, int second) const;
+    /* XXX: admissibleScale() of m_safe_version, O(E) once per graph */
+    double safeScale();
+    bool landmarksStale(const CSRGraph &graph, quint64 version) const;
+    bool prepareLandmarks();
+    int estimate(int node, int finish, double scale, bool landmarks) const;
+    bool search(int start, int finish, double scale, bool landmarks,
+      int *expanded);
+
+private:
+    double m_scale;
+    double m_used_scale;
+    double m_safe_scale;
+    quint64 m_safe_version;
+    bool m_compare;
+    int m_dijkstra_explored;
+    EpochArray m_settled;
+    BinaryHeap m_heap;
+    /* XXX: Tables of m_landmarks_version, built by a run or by
+     * saveLandmarks(), or read by loadLandmarks() */
+    Landmarks m_landmarks;
+    quint64 m_landmarks_version;
+    int m_landmark_count;
+    Landmarks::Selection m_selection;
+    bool m_landmarks_built;
+};
+
+#endif // ASTARALGORITHM_H
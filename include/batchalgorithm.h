@@ -0,0 +1,78 @@
+#ifndef BATCHALGORITHM_H
+#define BATCHALGORITHM_H
+
+#include "abstractalgorithm.h"
+#include "heap.h"
+
+/* XXX: Many (start, finish) pairs in one run. Queries are grouped by
+ * start, every group is answered from one shortest path tree, and the
+ * groups are spread over the thread pool. start and finish of execute()
+ * are not used, the queries come from setQueries(). */
+
+typedef struct
+{
+    int from;
+    int to;
+} batch_query_t;
+
+typedef struct
+{
+    int from;
+    int to;
+    int distance; /* -1 - no way */
+    int way; /* Index in getWays(), -1 - no way */
+} batch_result_t;
+
+/* XXX: Groups handled by one task, buffers are kept between rounds */
+typedef struct
+{
+    int begin;
+    int end;
+    int explored;
+    EpochArray distance;
+    EpochArray parent;
+    EpochArray target;
+    BinaryHeap heap;
+    WayArena ways;
+} batch_chunk_t;
+
+class BatchAlgorithm : public AbstractAlgorithm
+{
+    Q_OBJECT
+
+    enum
+    {
+      Round = 256 /* Groups between cancel/budget checks */
+    };
+
+public:
+     explicit BatchAlgorithm(QObject *parent = Q_NULLPTR);
+     ~BatchAlgorithm();
+     /* XXX: Refused while a batch runs, its worker reads them */
+     bool setQueries(const QVector<batch_query_t> &queries);
+     const QVector<batch_result_t> &getResults() const;
+     /* XXX: "start finish" pairs of node names, separated by new lines,
+      * "," or ";". Lines starting with "#" are skipped */
+     static bool parseQueries(QString text, QVector<batch_query_t> *queries);
+
+protected:
+    virtual bool algorithm(int start, int finish, bool order);
+    virtual void apply(GraphicsView *view, int start);
+    virtual bool select(GraphicsView *view, int *start, int *finish);
+    virtual bool cacheable() const;
+
+private:
+    void group();
+    void search(batch_chunk_t &chunk, int group, batch_result_t *results);
+    void collect(batch_chunk_t &chunk);
+
+private:
+    QVector<batch_query_t> m_queries;
+    QVector<batch_result_t> m_results;
+    /* XXX: Query indices sorted by start, groups are ranges of it */
+    QVector<int> m_order;
+    QVector<int> m_groups;
+    QVector<batch_chunk_t> m_chunks;
+};
+
+#endif // BATCHALGORITHM_H
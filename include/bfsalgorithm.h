@@ -1,19 +1,67 @@
 #ifndef BFSALGORITHM_H
 #define BFSALGORITHM_H
 
+#include <functional>
+#include <QAtomicInt>
+#include <QPair>
+
 #include "abstractalgorithm.h"
 
+/* XXX: Part of a level handled by one thread */
+typedef struct
+{
+    int begin;
+    int end;
+    QVector<int> found;
+    QVector<qint64> keys;
+} bfs_chunk_t;
+
 class BFSAlgorithm : public AbstractAlgorithm
 {
     Q_OBJECT
 
+    enum
+    {
+        Forward = 1,
+        Backward = 2,
+        ChunkSize = 4096, /* Nodes per parallel task */
+        Alpha = 14, /* Top-down -> bottom-up switch, frontier arcs ratio */
+        Beta = 24 /* Bottom-up -> top-down switch, frontier nodes ratio */
+    };
+
 public:
      explicit BFSAlgorithm(QObject *parent = Q_NULLPTR);
      ~BFSAlgorithm();
 
 protected:
-    virtual void algorithm(Node *start, Node *finish, GraphicsView *view,
-	bool order);
+    virtual bool algorithm(int start, int finish, bool order);
+
+private:
+    bool unidirectional(int start, int finish, bool order);
+    bool bidirectional(int start, int finish, bool order);
+    void topDown(int begin, int end, bool order);
+    void bottomUp(int begin, int end, bool order);
+    void split(int begin, int end);
+    void runChunks(QVector<bfs_chunk_t> &chunks,
+      std::function<void(bfs_chunk_t &)> fn) const;
+
+private:
+    /* XXX: Visit order, levels one after another. Position in it is the
+     * queue position of the sequential BFS, it decides ties */
+    QVector<int> m_order;
+    EpochArray m_position;
+    /* XXX: INF for every node between runs */
+    QVector<QAtomicInt> m_claim;
+    QVector<quint64> m_visited;
+    QVector<quint64> m_frontier;
+    QVector<int> m_next;
+    QVector<bfs_chunk_t> m_chunks;
+    QVector<QPair<qint64, int> > m_sorted;
+    /* XXX: Bidirectional search state */
+    QVector<int> m_forward;
+    QVector<int> m_backward;
+    EpochArray m_side;
+    EpochArray m_depth;
 };
 
 #endif // BFSALGORITHM_H
@@ -0,0 +1,112 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <functional>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+#include "csrgraph.h"
+#include "epocharray.h"
+#include "heap.h"
+
+/* XXX: Contraction hierarchy of a static graph. Nodes are contracted one
+ * by one, cheapest first (edge difference plus contracted neighbours),
+ * a shortcut u - w replaces u - v - w unless a short witness search finds
+ * another way as good. A query runs Dejikstra upwards (to higher ranks)
+ * from both ends, so it settles a few hundred nodes instead of the graph.
+ * Shortcuts keep the node they skip, ways are unpacked through it. */
+
+/* XXX: Hierarchy file: hierarchy_header_t, size qint32 ranks, then arcs
+ * hierarchy_arc_t. Native byte order like the distance matrix. The
+ * fingerprint of the graph it was built for rejects a stale file.
+ * Written to any device, a file of its own or a graph file section. */
+
+#define HIERARCHY_MAGIC "G2DH"
+#define HIERARCHY_VERSION 1
+
+typedef struct
+{
+    char magic[4];
+    qint32 version;
+    qint32 size;
+    qint32 arcs;
+    quint64 fingerprint;
+} hierarchy_header_t;
+
+typedef struct
+{
+    qint32 from;
+    qint32 to;
+    qint32 weight;
+    qint32 middle; /* -1 - arc of the graph itself */
+} hierarchy_arc_t;
+
+class ContractionHierarchy
+{
+    enum
+    {
+      WitnessLimit = 128 /* Nodes settled by a witness search at most */
+    };
+
+public:
+    ContractionHierarchy();
+    ~ContractionHierarchy();
+
+    void clear();
+    bool isEmpty() const;
+    int size() const;
+    int shortcuts() const;
+    /* XXX: stop(steps) true aborts, the hierarchy is cleared then */
+    bool build(const CSRGraph &graph, std::function<bool(int)> stop);
+    /* XXX: Distance or INF, way gets the nodes from start to finish */
+    int query(int start, int finish, QVector<int> *way);
+    /* XXX: Nodes settled by the last query */
+    int explored() const;
+    bool save(QIODevice *device) const;
+    /* XXX: False if the data was built for another graph */
+    bool load(QIODevice *device, const CSRGraph &graph);
+
+private:
+    int priority(int node);
+    /* XXX: Shortcuts contraction of node needs, into m_pending */
+    int simulate(int node);
+    void witness(int source, int skip, int limit, int targets);
+    void addShortcut(int from, int to, int weight, int middle);
+    void detach(int node, QVector<hierarchy_arc_t> *arcs);
+    void split(const QVector<hierarchy_arc_t> &arcs);
+    void unpack(int from, int to, QVector<int> *way);
+
+    static inline quint64 arcKey(int from, int to)
+    {
+        return ((quint64) (quint32) from << 32) | (quint32) to;
+    }
+
+private:
+    /* XXX: Arcs to higher ranks, and arcs from higher ranks kept by their
+     * head, so the backward search walks them from finish */
+    CSRGraph m_up;
+    CSRGraph m_down;
+    QVector<int> m_rank;
+    QHash<quint64, int> m_middle;
+    quint64 m_fingerprint;
+    int m_shortcuts;
+    int m_explored;
+    /* XXX: Remaining graph of the build, shortcuts inserted in place */
+    CSRGraph m_out;
+    CSRGraph m_in;
+    QVector<int> m_contracted;
+    QVector<int> m_priority;
+    QVector<hierarchy_arc_t> m_pending;
+    EpochArray m_witness;
+    /* XXX: Heads of the shortcuts the witness search looks for */
+    EpochArray m_target;
+    /* XXX: Query state, forward and backward side */
+    EpochArray m_distance[2];
+    EpochArray m_parent[2];
+    BinaryHeap m_heap[2];
+    QVector<int> m_stack;
+};
+
+#endif // CONTRACTIONHIERARCHY_H
@@ -0,0 +1,70 @@
+#ifndef CSRGRAPH_H
+#define CSRGRAPH_H
+
+#include <QVector>
+
+/* XXX: Compressed sparse row adjacency with slack.
+ * Neighbors of node i are m_neighbors[m_starts[i] .. m_starts[i] +
+ * m_degrees[i]), sorted by id, so "little bit"/"biggest bit" ordering is
+ * a plain forward or backward walk over the row. A row owns
+ * m_capacities[i] slots, so an edit shifts one row only. A full row moves
+ * to the tail with double capacity, the hole is reclaimed by compact()
+ * once holes outgrow the arcs. Storage is implicitly shared, a copy for
+ * an algorithm run is O(1). */
+
+typedef struct
+{
+    int from;
+    int to;
+    int weight;
+} arc_t;
+
+class CSRGraph
+{
+public:
+    CSRGraph();
+    ~CSRGraph();
+
+    void build(int size, QVector<arc_t> arcs);
+    /* XXX: Rows given as offsets[size + 1], sorted and unique already
+     * (a checked file), copied as they are */
+    void assign(int size, const qint32 *offsets, const qint32 *neighbors,
+      const qint32 *weights);
+    void clear();
+    /* XXX: In place edits. Rows cut by resize() must have no arcs left
+     * pointing to them */
+    void resize(int size);
+    bool insertArc(int from, int to, int weight);
+    bool removeArc(int from, int to);
+    bool setWeight(int from, int to, int weight);
+    bool contains(int from, int to) const;
+    bool isEmpty() const;
+    int size() const;
+    int arcCount() const;
+    int degree(int node) const;
+    const int *neighbors(int node) const;
+    const int *weights(int node) const;
+    int weight(int from, int to) const;
+    CSRGraph reversed() const;
+    /* XXX: Hash of every arc, tells if a file was made for this graph */
+    quint64 fingerprint() const;
+
+    /* XXX: Dense export view. O(V^2), use only for the text storage format */
+    QVector<QVector<int> > toMatrix() const;
+
+private:
+    int find(int from, int to) const;
+    void grow(int node);
+    void compact();
+
+private:
+    QVector<int> m_starts;
+    QVector<int> m_degrees;
+    QVector<int> m_capacities;
+    QVector<int> m_neighbors;
+    QVector<int> m_weights;
+    int m_arcs;
+    int m_holes;
+};
+
+#endif // CSRGRAPH_H
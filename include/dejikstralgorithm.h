@@ -2,29 +2,113 @@
 #define DEJIKSTRALGORITHM_H
 
 #include "abstractalgorithm.h"
+#include "contractionhierarchy.h"
+#include "dynamictree.h"
+#include "heap.h"
 
 class DejikstraAlgorithm : public AbstractAlgorithm
 {
     Q_OBJECT
 
+    enum
+    {
+      MaxWays = 64, /* Limit of equal-cost ways shown */
+      Forward = 1,
+      Backward = 2
+    };
+
 public:
      explicit DejikstraAlgorithm(QObject *parent = Q_NULLPTR);
      ~DejikstraAlgorithm();
+     void setHeap(HeapID heap);
+     /* XXX: Also write distances between every two nodes to a file */
+     void setAllPairs(bool all_pairs);
+     /* XXX: Keep the tree of the last start and repair it after edits */
+     void setDynamic(bool dynamic);
+     /* XXX: Answer single pair runs by a contraction hierarchy */
+     void setHierarchy(bool hierarchy);
+     /* XXX: Hierarchy of the model graph, a file next to its graph file
+      * or a section of it. save() builds the hierarchy first if the
+      * graph changed since. Another graph, the renumbered one of a graph
+      * file, gets a hierarchy of its own, the kept one is left alone */
+     bool saveHierarchy(QIODevice *device, const CSRGraph *graph = nullptr);
+     bool loadHierarchy(QIODevice *device);
+     QString matrixFile() const;
+     virtual void initGraph();
 
 protected:
-    virtual void algorithm(Node *start, Node *finish, GraphicsView *view,
-    bool order);
-    bool checkBranch(QVector<int> &marked, Node *finish, GraphicsView *view,
-	bool reset);
+    virtual bool algorithm(int start, int finish, bool order);
+    virtual void apply(GraphicsView *view, int start);
+    virtual void configure(Tab *tab);
+    virtual bool cacheable() const;
+    virtual QString variant() const;
+    virtual void saveResult(algorithm_result_t *result) const;
+    virtual void loadResult(const algorithm_result_t &result);
+
+private:
+        template<class Heap>
+        bool search(Heap &heap, int start, int finish);
+        template<class Heap>
+        bool bidirectionalSearch(Heap &forward, Heap &backward, int start,
+          int finish);
+        template<class Heap>
+        bool searchWith(Heap *heaps, int start, int finish);
+        bool treeSearch(int start, int finish);
+        bool hierarchySearch(int start, int finish);
+        void tightPreds(int finish);
+        void addPred(int node, int pred);
+        QString distance(int node) const;
+        void collectWays(int start, int finish);
+        /* XXX: incremental - redo only nodes the tree repair touched */
+        void updateToolTips(GraphicsView *view, bool incremental) const;
+        void createRaport(Node *first, GraphicsView *view, bool incremental);
+        void printWays(GraphicsView *view) const;
+        bool writeMatrix();
+        void showMatrix(Node *first, GraphicsView *view) const;
 
 private:
-        bool wasVisitedFromNode(int from, Vertex *node) const;
-        QVector<QVector<int> > markWay(GraphicsView *view, Node *finish,
-	  bool reset);
-        void updateToolTips(GraphicsView *view) const;
-        void createRaport(Node *first, GraphicsView *view) const;
-        void printWays(GraphicsView *view, QVector<QVector<int> > ways,
-	 Node *finish) const;
+        HeapID m_heap;
+        /* XXX: Forward/Backward bits of settled nodes */
+        EpochArray m_settled;
+        EpochArray m_reverse_shortest;
+        /* XXX: Predecessors DAG as linked lists in one pool */
+        EpochArray m_pred_head;
+        QVector<int> m_pred_node;
+        QVector<int> m_pred_next;
+        /* XXX: Stacks of the ways walk */
+        QVector<int> m_walk;
+        QVector<int> m_walk_cursor;
+        /* XXX: Forward and backward queue of each kind */
+        BinaryHeap m_binary[2];
+        PairingHeap m_pairing[2];
+        RadixHeap m_radix[2];
+        /* XXX: Tree of the last unidirectional start, of m_tree_version */
+        DynamicTree m_tree;
+        quint64 m_tree_version;
+        /* XXX: Arc edits since m_tree_version, taken by initGraph() */
+        QVector<arc_change_t> m_changes;
+        quint64 m_changes_version;
+        bool m_changes_valid;
+        bool m_dynamic;
+        /* XXX: The last result lives in m_tree, not in m_shortest */
+        bool m_use_tree;
+        bool m_repaired;
+        /* XXX: Tree version before the last repair, and the one tooltips
+         * and raport lines show, NoVersion if they show something else */
+        quint64 m_repaired_from;
+        quint64 m_shown_version;
+        /* XXX: Raport line by node id, joined in scene order */
+        QVector<QString> m_raport_lines;
+        QVector<int> m_raport_order;
+        /* XXX: Hierarchy of m_hierarchy_version, built by a run or by
+         * saveHierarchy(), or read by loadHierarchy() */
+        ContractionHierarchy m_hierarchy;
+        quint64 m_hierarchy_version;
+        bool m_hierarchy_enabled;
+        bool m_hierarchy_built;
+        bool m_all_pairs;
+        bool m_matrix_ready;
+        int m_matrix_method;
 };
 
 #endif // DEJIKSTRALGORITHM_H
@@ -3,6 +3,10 @@
 
 #include "abstractalgorithm.h"
 
+/* XXX: Iterative DFS. Explicit stack of node ids plus a per-node cursor
+ * into its row, both sized once per run, so deep chains need neither
+ * recursion nor allocation per node */
+
 class DFSAlgorithm : public AbstractAlgorithm
 {
     Q_OBJECT
@@ -10,10 +14,19 @@ class DFSAlgorithm : public AbstractAlgorithm
 public:
      explicit DFSAlgorithm(QObject *parent = Q_NULLPTR);
      ~DFSAlgorithm();
+     QVector<int> getDiscovery() const;
+     QVector<int> getFinish() const;
 
 protected:
-    virtual void algorithm(Node *start, Node *finish, GraphicsView *view,
-    bool order);
+    virtual bool algorithm(int start, int finish, bool order);
+    virtual void configure(Tab *tab);
+
+private:
+    QVector<int> m_stack;
+    EpochArray m_cursor;
+    /* XXX: -1 - not reached (discovery) or still on stack (finish) */
+    EpochArray m_discovery;
+    EpochArray m_finish;
 };
 
 #endif // DFSALGORITHM_H
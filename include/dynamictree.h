@@ -0,0 +1,73 @@
+#ifndef DYNAMICTREE_H
+#define DYNAMICTREE_H
+
+#include <functional>
+#include <QVector>
+
+#include "csrgraph.h"
+#include "epocharray.h"
+#include "graphmodel.h"
+#include "heap.h"
+
+/* XXX: Shortest path tree of one start, kept between runs and repaired
+ * after arc edits instead of searched again (Ramalingam-Reps style).
+ * An arc got cheaper or new: its head is relaxed and the gain spreads
+ * by Dejikstra. A tree arc got dearer or gone: the subtree under it loses
+ * its distances, takes the best arcs coming in from the rest of the tree
+ * and settles by Dejikstra again. Work follows the changed region only. */
+
+class DynamicTree
+{
+public:
+    DynamicTree();
+    ~DynamicTree();
+
+    void clear();
+    int source() const;
+    int size() const;
+    /* XXX: stop(steps) true aborts, the tree is cleared then */
+    bool build(const CSRGraph &graph, int source,
+      std::function<bool(int)> stop);
+    /* XXX: graph and reverse are already edited by all changes */
+    void update(const CSRGraph &graph, const CSRGraph &reverse,
+      const QVector<arc_change_t> &changes);
+    /* XXX: Nodes whose distance was touched by the last build or update */
+    const QVector<int> &changed() const;
+    int work() const;
+
+    inline int distance(int node) const
+    {
+        return m_distance[node];
+    }
+
+    inline int parent(int node) const
+    {
+        return m_parent[node];
+    }
+
+private:
+    void link(int node, int parent);
+    void unlink(int node);
+    void touch(int node);
+    void lower(int node, int parent, int distance);
+    void cutSubtree(int root);
+    bool settle(const CSRGraph &graph, std::function<bool(int)> stop);
+
+private:
+    QVector<int> m_distance;
+    QVector<int> m_parent;
+    /* XXX: Children of a node as a doubly linked list */
+    QVector<int> m_child;
+    QVector<int> m_next;
+    QVector<int> m_prev;
+    BinaryHeap m_heap;
+    EpochArray m_touched;
+    QVector<int> m_changed;
+    QVector<int> m_stack;
+    /* XXX: Nodes that lost their distance in this update */
+    QVector<int> m_cut;
+    int m_source;
+    int m_work;
+};
+
+#endif // DYNAMICTREE_H
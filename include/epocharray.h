@@ -0,0 +1,46 @@
+#ifndef EPOCHARRAY_H
+#define EPOCHARRAY_H
+
+#include <QVector>
+
+/* XXX: Int array with O(1) reset. A slot is valid only while its stamp
+ * equals the current epoch, otherwise it reads as the empty value. So a
+ * new run pays for the slots it touches, not for the whole graph.
+ * Accessors are inline, they sit in the innermost search loops. */
+
+class EpochArray
+{
+public:
+    explicit EpochArray(int empty = -1);
+    ~EpochArray();
+
+    /* XXX: Grows storage if needed and drops every value */
+    void reset(int size);
+    int size() const;
+    QVector<int> toVector() const;
+
+    inline bool contains(int i) const
+    {
+        return m_stamps[i] == m_epoch;
+    }
+
+    inline int value(int i) const
+    {
+        return m_stamps[i] == m_epoch ? m_values[i] : m_empty;
+    }
+
+    inline void set(int i, int value)
+    {
+        m_values[i] = value;
+        m_stamps[i] = m_epoch;
+    }
+
+private:
+    QVector<int> m_values;
+    QVector<quint32> m_stamps;
+    quint32 m_epoch;
+    int m_size;
+    int m_empty;
+};
+
+#endif // EPOCHARRAY_H
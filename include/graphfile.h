@@ -0,0 +1,135 @@
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QPointF>
+#include <QSaveFile>
+#include <QString>
+#include <QVector>
+
+#include "csrgraph.h"
+#include "graphmodel.h"
+
+/* XXX: Graph container, one file for all a graph needs. The text matrix
+ * with its .conf and _tt.conf is O(V^2) of mostly zeros in three files.
+ * graph_file_header_t, then sections, each 8 byte aligned, then the
+ * table of contents, a graph_section_t per section:
+ *   TOPO - qint32 nodes, arcs, offsets[nodes + 1], neighbors[arcs],
+ *     weights[arcs]; CSR rows, nodes renumbered 0..nodes-1 in id order,
+ *     holes left by deleted nodes are dropped;
+ *   LAYT - double x, y per node;
+ *   LABL - qint32 offsets[nodes + 1], then label text, UTF-8. Labels
+ *     only, computed data shown in tooltips stays out;
+ *   HIER, LMRK - contraction hierarchy and landmarks, the same bytes
+ *     their own files would hold.
+ * Native byte order like the distance matrix. open() maps the file and
+ * reads the table only, a section is checked when it's used first and
+ * read in place, an unused one costs nothing. Writing goes to a
+ * temporary file, commit() syncs it once and renames it over the old
+ * one, so a crash leaves either file whole. */
+
+#define GRAPH_FILE_MAGIC "G2DG"
+#define GRAPH_FILE_VERSION 2
+
+#define GRAPH_SECTION_TOPOLOGY "TOPO"
+#define GRAPH_SECTION_LAYOUT "LAYT"
+#define GRAPH_SECTION_LABELS "LABL"
+#define GRAPH_SECTION_HIERARCHY "HIER"
+#define GRAPH_SECTION_LANDMARKS "LMRK"
+
+typedef struct
+{
+    char magic[4];
+    qint32 version;
+    qint32 sections;
+    qint32 reserved;
+    qint64 toc; /* Offset of the table of contents */
+    qint64 size; /* Whole file, a truncated one is rejected */
+} graph_file_header_t;
+
+typedef struct
+{
+    char tag[4];
+    qint32 reserved;
+    qint64 offset;
+    qint64 size;
+} graph_section_t;
+
+class GraphFile
+{
+    enum
+    {
+      Alignment = 8
+    };
+
+    /* XXX: State of a lazily checked section */
+    enum
+    {
+      Unchecked,
+      Valid,
+      Invalid
+    };
+
+public:
+    GraphFile();
+    ~GraphFile();
+
+    bool open(QString filename);
+    void close();
+    bool isOpen() const;
+    bool hasSection(const char *tag) const;
+    /* XXX: Raw bytes of a section, empty if there is none. Points into
+     * the mapping, valid until close() */
+    QByteArray section(const char *tag) const;
+    /* XXX: 0 if the topology is missing or broken */
+    int size() const;
+    int arcCount() const;
+    CSRGraph graph() const;
+    /* XXX: (0, 0) and empty if the section is missing or broken */
+    QPointF position(int node) const;
+    QString label(int node) const;
+
+    bool create(QString filename);
+    /* XXX: TOPO, LAYT and LABL of the model, labels indexed by node id */
+    bool writeGraph(const GraphModel &model, const QVector<QString> &labels);
+    /* XXX: TOPO of the last writeGraph(), ids renumbered. Data of other
+     * sections must be made for this graph, not for the model */
+    const CSRGraph &writtenGraph() const;
+    bool writeSection(const char *tag, const QByteArray &data);
+    bool commit();
+    void cancel();
+
+private:
+    const graph_section_t *find(const char *tag) const;
+    bool checkTopology() const;
+    bool checkLayout() const;
+    bool checkLabels() const;
+    bool beginSection(const char *tag);
+    bool writeData(const void *data, qint64 size);
+    bool endSection();
+
+private:
+    QFile m_file;
+    uchar *m_data;
+    const graph_file_header_t *m_header;
+    const graph_section_t *m_toc;
+    /* XXX: Sections checked on first use */
+    mutable int m_topology;
+    mutable int m_layout;
+    mutable int m_labels;
+    mutable int m_nodes;
+    mutable int m_arcs;
+    mutable const qint32 *m_offsets;
+    mutable const qint32 *m_neighbors;
+    mutable const qint32 *m_weights;
+    mutable const double *m_positions;
+    mutable const qint32 *m_label_offsets;
+    mutable const char *m_text;
+    /* XXX: Writing state */
+    QSaveFile m_save;
+    QVector<graph_section_t> m_sections;
+    CSRGraph m_written;
+};
+
+#endif // GRAPHFILE_H
@@ -11,12 +11,14 @@
 #include <QGraphicsEllipseItem>
 #include <QFontMetrics>
 #include <QRegExp>
+#include <QHash>
 
 #include "log.h"
 #include "mainwindow.h"
 #include "node.h"
 #include "edge.h"
 #include "abstractitem.h"
+#include "graphmodel.h"
 
 class MainWindow;
 class Node;
@@ -79,13 +81,21 @@ public:
     Node *findNodeByIndex(int index) const;
     void markNode(Node *node, int mark);
     void directableEdge(Edge *edge);
-    void restoreEdges(QVector<QVector<int> > graph);
+    void restoreEdges(const CSRGraph &graph);
+    /* XXX: Model only, no items. Batch queries run on it, the scene
+     * takes new nodes again after deleteAll() */
+    void loadGraph(const CSRGraph &graph);
+    bool isHeadless() const;
     Node *findNodeByName(int name) const;
+    int nextNodeIndex() const;
     void deleteAll();
     void setEdgeWeight(Edge *edge);
     QSize getFontMetrix(QFont font, QString string) const;
     bool isStringValid(QString string, QString expression) const;
     void setNodeToolTip(Node *node);
+    void registerEdge(Edge *edge);
+    Edge *findEdge(const Node *from, const Node *to) const;
+    const GraphModel &getModel() const;
 
 protected:
     void mousePressEvent(QMouseEvent *event);
@@ -98,6 +108,10 @@ private:
     size_t horizontalOffset() const;
     bool isNodeIntersected(QRectF rect) const;
     void updateMarks();
+    void indexNode(Node *node);
+    void unindexNode(Node *node);
+    void unindexEdge(Edge *edge);
+    void directEdge(Node *from, Node *to);
 
 public slots:
     void modeHandler(QAction*, AbstractItem*);
@@ -115,6 +129,12 @@ private:
         bool m_moving_captured;
         Node *m_start_node;
         Node *m_finish_node;
+        GraphModel m_model;
+        /* XXX: id -> node, and min-heap of released ids below m_index.size() */
+        QVector<Node*> m_index;
+        QVector<int> m_free_ids;
+        /* XXX: (from, to) -> edge, both directions for undirected edges */
+        QHash<quint64, Edge*> m_edge_index;
 };
 
 extern str2mode_t str2mode_arr[];
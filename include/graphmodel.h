@@ -0,0 +1,86 @@
+#ifndef GRAPHMODEL_H
+#define GRAPHMODEL_H
+
+#include <QVector>
+#include <QPointF>
+
+#include "csrgraph.h"
+
+/* XXX: Headless mirror of the scene graph.
+ * Node id is node's name - 1. Undirected edge is kept as two arcs,
+ * directed one as a single arc. GraphicsView keeps it in sync on every
+ * edit, so algorithms never have to touch Node/Edge items. Arcs live
+ * right in the CSR adjacency (and its reverse) the algorithms read,
+ * edited in place, so a run or a save never rebuilds it.
+ * version() changes on every edit, positions included (A* heuristic
+ * depends on them), and never goes back, clear() too. */
+
+/* XXX: One arc edit, weight -1 - no arc */
+typedef struct
+{
+    quint64 version; /* Model version right after the edit */
+    int from;
+    int to;
+    int before;
+    int after;
+} arc_change_t;
+
+class GraphModel
+{
+    enum
+    {
+      LogLimit = 4096 /* Arc edits kept, more cost a full search anyway */
+    };
+
+public:
+    GraphModel();
+    ~GraphModel();
+
+    void addNode(int id);
+    void removeNode(int id);
+    bool isNode(int id) const;
+    int capacity() const;
+    int nodeCount() const;
+    void setPosition(int id, QPointF pos);
+    QPointF position(int id) const;
+    const QVector<QPointF> &positions() const;
+
+    bool addEdge(int first, int second, int weight);
+    bool removeEdge(int first, int second);
+    bool setWeight(int first, int second, int weight);
+    bool setDirected(int from, int to);
+    int weight(int from, int to) const;
+    void clear();
+    /* XXX: Replaces everything by the graph, nodes 0..size-1 at (0, 0).
+     * For imports too big to put on the scene */
+    void assign(const CSRGraph &graph);
+
+    /* XXX: O(1), the copy shares storage until the next edit */
+    CSRGraph toCSR() const;
+    const CSRGraph &graph() const;
+    const CSRGraph &reverse() const;
+    quint64 version() const;
+    /* XXX: Arc edits made after the given version. False when they are
+     * not known any more or nodes were added or removed since */
+    bool changesSince(quint64 version, QVector<arc_change_t> *changes) const;
+
+private:
+    bool addArc(int from, int to, int weight);
+    bool removeArc(int from, int to);
+    void logChange(int from, int to, int before, int after);
+    void resetLog();
+
+private:
+    QVector<bool> m_alive;
+    CSRGraph m_graph;
+    /* XXX: Arcs coming in, to drop them with a node and for algorithms
+     * walking backwards */
+    CSRGraph m_reverse;
+    QVector<QPointF> m_positions;
+    int m_count;
+    quint64 m_version;
+    QVector<arc_change_t> m_changes;
+    quint64 m_log_base;
+};
+
+#endif // GRAPHMODEL_H
@@ -0,0 +1,108 @@
+#ifndef GRAPHTEXT_H
+#define GRAPHTEXT_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "csrgraph.h"
+
+/* XXX: Readers of the text formats:
+ *   Matrix - the old .txt, row i holds the weights of arcs from node i,
+ *     0 - no arc;
+ *   EdgeList - "from to [weight]" per line, node names from 1 like the
+ *     batch queries, weight 1 if omitted, "#" or "%" starts a comment.
+ *     One line is one arc, an undirected edge takes two lines;
+ *   Dimacs - shortest path challenge .gr, "p sp n m", then "a u v w";
+ *   Metis - "n m [fmt [ncon]]", then line i lists neighbours of node i
+ *     (with edge weights if fmt says so), vertex weights are skipped;
+ *   MatrixMarket - coordinate general or symmetric, an entry (i, j) is
+ *     an arc i -> j, real values rounded, pattern ones weigh 1;
+ *   Snap - "from to" from 0, "#" comments. Ids with holes are packed
+ *     to 0..n-1 keeping their order.
+ * Self loops of the benchmark formats are dropped, no search needs them.
+ * Numbers are parsed by hand, no line is ever turned into a QString.
+ * Only nonzero arcs are kept, so memory is O(E), not O(V^2).
+ * A line format is read in fixed chunks one after another. A matrix is
+ * mapped and cut into newline aligned pieces parsed on all cores; rows
+ * come in order, so the pieces are glued into CSR with no sorting. */
+
+/* XXX: Piece of a mapped matrix file, parsed by one task */
+typedef struct
+{
+    qint64 begin;
+    qint64 end;
+    int lines;
+    int error_line; /* Within the piece, 0 - none */
+    int columns;
+    QVector<int> degrees; /* One per row */
+    QVector<int> neighbors;
+    QVector<int> weights;
+} matrix_piece_t;
+
+class GraphText
+{
+    enum
+    {
+      ChunkSize = 1 << 20, /* Bytes read at once, grows for a longer line */
+      PieceSize = 4 << 20 /* Matrix bytes parsed by one task at least */
+    };
+
+public:
+    enum Format
+    {
+        Matrix,
+        EdgeList,
+        Dimacs,
+        Metis,
+        MatrixMarket,
+        Snap
+    };
+
+    GraphText();
+    ~GraphText();
+
+    void clear();
+    bool read(QString filename, Format format);
+    /* XXX: Nodes, the largest name or the row count */
+    int size() const;
+    int arcCount() const;
+    /* XXX: Line of the last error, 0 - none */
+    int errorLine() const;
+    /* XXX: MB/s of the last read, to catch regressions */
+    double throughput() const;
+    CSRGraph graph() const;
+
+    static bool writeEdgeList(QString filename, const CSRGraph &graph);
+
+private:
+    bool readLines(QFile &file, Format format);
+    bool readMatrix(QFile &file);
+    bool parseLine(const char *begin, const char *end, Format format);
+    bool parseArc(const char *begin, const char *end);
+    bool parseDimacs(const char *begin, const char *end);
+    bool parseMetis(const char *begin, const char *end);
+    bool parseMarket(const char *begin, const char *end);
+    bool parseSnap(const char *begin, const char *end);
+    bool finish(Format format);
+    static void parseMatrix(const uchar *data, matrix_piece_t &piece);
+
+private:
+    QVector<arc_t> m_arcs;
+    CSRGraph m_graph;
+    int m_size;
+    int m_line;
+    int m_error_line;
+    double m_throughput;
+    /* XXX: Header state of the formats that have one. Stage 1 - banner
+     * or problem line seen, 2 - Matrix Market size line seen too */
+    int m_stage;
+    int m_declared;
+    int m_vertex;
+    int m_metis_format;
+    int m_metis_ncon;
+    bool m_symmetric;
+    bool m_pattern;
+};
+
+#endif // GRAPHTEXT_H
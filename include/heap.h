@@ -0,0 +1,99 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <QVector>
+
+/* XXX: Min-priority queues for the Dejikstra algorithm.
+ * All of them share the same interface: push() inserts a value or lowers
+ * its key, pop() returns the smallest key. Binary and radix heaps keep
+ * stale duplicates instead of decreasing keys, so the caller has to skip
+ * values which were already settled. */
+
+enum HeapID
+{
+    BinaryHeapID,
+    PairingHeapID,
+    RadixHeapID
+};
+
+typedef struct
+{
+    int key;
+    int value;
+} heap_item_t;
+
+class BinaryHeap
+{
+public:
+    explicit BinaryHeap(int capacity = 0);
+
+    void push(int key, int value);
+    bool pop(int *key, int *value);
+    /* XXX: Storage is kept by clear(), so a reused heap allocates once */
+    void reserve(int capacity);
+    bool isEmpty() const;
+    int size() const;
+    void clear();
+
+private:
+    QVector<heap_item_t> m_items;
+};
+
+/* XXX: Values are used as node handles, so they have to be in
+ * [0, capacity). This is the only heap with a real decrease-key. */
+class PairingHeap
+{
+public:
+    explicit PairingHeap(int capacity = 0);
+
+    void push(int key, int value);
+    bool pop(int *key, int *value);
+    void reserve(int capacity);
+    bool isEmpty() const;
+    int size() const;
+    void clear();
+
+private:
+    int meld(int first, int second);
+    void cut(int node);
+
+private:
+    QVector<int> m_key;
+    QVector<int> m_child;
+    QVector<int> m_sibling;
+    QVector<int> m_prev;
+    QVector<bool> m_in_heap;
+    QVector<int> m_pairs;
+    int m_root;
+    int m_size;
+};
+
+/* XXX: Monotone heap: a pushed key must not be less than the last popped
+ * one. Holds for Dejikstra with non-negative weights (0..999 here). */
+class RadixHeap
+{
+    enum
+    {
+        Buckets = 33
+    };
+
+public:
+    explicit RadixHeap(int capacity = 0);
+
+    void push(int key, int value);
+    bool pop(int *key, int *value);
+    void reserve(int capacity);
+    bool isEmpty() const;
+    int size() const;
+    void clear();
+
+private:
+    int bucket(int key) const;
+
+private:
+    QVector<heap_item_t> m_buckets[Buckets];
+    int m_last;
+    int m_size;
+};
+
+#endif // HEAP_H
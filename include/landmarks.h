@@ -0,0 +1,118 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <functional>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+#include "csrgraph.h"
+#include "heap.h"
+
+#ifndef INF
+#define INF INT32_MAX
+#endif
+
+/* XXX: ALT lower bounds. For a landmark L the triangle inequality gives
+ * d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L), the
+ * best of them over all landmarks is a consistent A* heuristic. Tables
+ * are node-major, so one bound reads two short rows. */
+
+/* XXX: Landmark file: landmark_header_t, count qint32 landmark ids, then
+ * size * count qint32 forward and as many backward distances, INF - no
+ * way. Native byte order, checked by the graph fingerprint. Written to
+ * any device, a file of its own or a graph file section. */
+
+#define LANDMARK_MAGIC "G2DL"
+#define LANDMARK_VERSION 1
+
+typedef struct
+{
+    char magic[4];
+    qint32 version;
+    qint32 size;
+    qint32 count;
+    qint32 selection;
+    qint32 reserved;
+    quint64 fingerprint;
+} landmark_header_t;
+
+/* XXX: One table column, forward or backward, computed by one task */
+typedef struct
+{
+    int landmark;
+    bool backward;
+    QVector<qint32> distances;
+    BinaryHeap heap;
+} landmark_task_t;
+
+class Landmarks
+{
+public:
+    enum Selection
+    {
+        Farthest, /* Each next one the farthest from those chosen */
+        Degree /* Nodes of the highest degree */
+    };
+
+    enum
+    {
+      MaxCount = 64
+    };
+
+    Landmarks();
+    ~Landmarks();
+
+    void clear();
+    bool isEmpty() const;
+    int size() const;
+    int count() const;
+    Selection selection() const;
+    int landmark(int i) const;
+    /* XXX: stop(steps) true aborts, the tables are cleared then */
+    bool build(const CSRGraph &graph, int count, Selection selection,
+      std::function<bool(int)> stop);
+    bool save(QIODevice *device) const;
+    /* XXX: False if the data was built for another graph */
+    bool load(QIODevice *device, const CSRGraph &graph);
+
+    inline int bound(int node, int target) const
+    {
+        const qint32 *from_node = m_forward.constData() + node * m_count;
+        const qint32 *from_target = m_forward.constData() + target * m_count;
+        const qint32 *to_node = m_backward.constData() + node * m_count;
+        const qint32 *to_target = m_backward.constData() + target * m_count;
+        int best = 0;
+
+        for(int l=0; l<m_count; l++)
+        {
+            if (from_node[l] != INF && from_target[l] != INF)
+                best = qMax(best, from_target[l] - from_node[l]);
+
+            if (to_node[l] != INF && to_target[l] != INF)
+                best = qMax(best, to_node[l] - to_target[l]);
+        }
+
+        return best;
+    }
+
+private:
+    bool selectFarthest(const CSRGraph &graph, int count,
+      std::function<bool(int)> stop);
+    void selectDegree(const CSRGraph &graph, const CSRGraph &reverse,
+      int count);
+    static void distances(const CSRGraph &graph, int source,
+      QVector<qint32> *result, BinaryHeap &heap);
+
+private:
+    QVector<int> m_landmarks;
+    /* XXX: [node * count + l] - d(l, node) and d(node, l) */
+    QVector<qint32> m_forward;
+    QVector<qint32> m_backward;
+    int m_size;
+    int m_count;
+    Selection m_selection;
+    quint64 m_fingerprint;
+};
+
+#endif // LANDMARKS_H
@@ -4,6 +4,7 @@
 #include <QStringList>
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QProgressDialog>
 
 #include "abstractwindow.h"
 #include "graphicsview.h"
@@ -13,6 +14,7 @@
 
 class GraphicsView;
 class AbstractAlgorithm;
+class BatchAlgorithm;
 class Raport;
 
 class MainWindow : public AbstractWindow
@@ -32,6 +34,14 @@ public:
     void createRaport();
     void showRaport();
     void showMessage(QString msg);
+    void showProgress(AbstractAlgorithm *algorithm);
+    /* XXX: Runs "start finish" pairs, see BatchAlgorithm::parseQueries() */
+    void runBatch(QString queries);
+    /* XXX: AlgorithmID, created on first use. Dejikstra and A* own the
+     * precomputed files stored next to the graph */
+    AbstractAlgorithm *getAlgorithm(int id);
+    /* XXX: The one last run, its signals drive the progress dialog */
+    AbstractAlgorithm *currentAlgorithm() const;
     QString openInputDialog(QString title, QString msg, bool *ok);
     ~MainWindow();
 
@@ -40,11 +50,14 @@ private:
         QToolBar *createSettingsBar(QWidget *parent, QToolBar **bar);
         GraphicsView *createGraphicsView(QWidget *parent, GraphicsView **view);
         void setBackgroundColor();
-        AbstractAlgorithm *createAlgorithm(QObject *parent);
+        AbstractAlgorithm *createAlgorithm();
+        void switchAlgorithm(AbstractAlgorithm *algorithm);
         void restoreItems();
 
 private slots:
         void handleControlEvent();
+        void updateProgress(int value, int maximum);
+        void hideProgress();
 signals:
         void execute();
 
@@ -53,7 +66,10 @@ private:
         GraphicsView *m_view;
         SettingsWindow *m_settings;
         AbstractAlgorithm *m_algorithm;
+        QVector<AbstractAlgorithm*> m_algorithms;
+        BatchAlgorithm *m_batch;
         Raport *m_raport;
+        QProgressDialog *m_progress;
 };
 
 #endif // MAINWINDOW_H
@@ -36,6 +36,11 @@ public:
     bool isAmongNeighbors(Node *node) const;
     Edge *getSelectedEdge() const;
     QString text() const;
+    /* XXX: Name given by the user. The tooltip shows it, algorithms may
+     * append computed data to the tooltip, never to the label */
+    void setLabel(const QString label);
+    QString label() const;
+    int index() const;
 
     void addEdge(Node *first, Node *second, Edge **edge);
     bool delEdge(Edge *edge);
@@ -69,9 +74,11 @@ signals:
 
 private:
     QString m_text;
+    QString m_label;
     bool m_edge_mode;
     QVector<Edge*> m_edges;
     QVector<Node*> m_neighbors;
+    int m_index;
 };
 
 #endif // NODE_H
@@ -1,7 +1,10 @@
 #ifndef RAPORT_H
 #define RAPORT_H
 
+#include <QPushButton>
+
 #include "abstractwindow.h"
+#include "allpairs.h"
 
 class Raport : public AbstractWindow
 {
@@ -10,7 +13,8 @@ class Raport : public AbstractWindow
     enum
     {
       Width = 450,
-      Height = 150
+      Height = 150,
+      PageSize = 100 /* Matrix lines per page */
     };
 
 public:
@@ -20,13 +24,34 @@ public:
     void setRaport(QString);
     void appendRaport(QVector<int>, QString msg);
     void appendRaport(QString msg);
+    /* XXX: Pages through a distance matrix file, names are indexed by
+     * node id, empty for free ids */
+    bool setMatrix(QString filename, QVector<QString> names, int row = 0);
+    /* XXX: Pages through ready lines, PageSize lines per page */
+    void setTable(QVector<QString> lines);
+    void clearPages();
 
 private:
     void layout();
+    int pageCount() const;
+    void showPage(int page);
+    QString matrixPage(int page);
+
+private slots:
+    void prevPage();
+    void nextPage();
 
 private:
     QLabel *m_lbl;
     QWidget *m_parent;
+    QLabel *m_page_lbl;
+    QLabel *m_page_info;
+    QPushButton *m_prev;
+    QPushButton *m_next;
+    DistanceMatrix m_matrix;
+    QVector<QString> m_names;
+    QVector<QString> m_lines;
+    int m_page;
 };
 
 #endif // RAPORT_H
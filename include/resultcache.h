@@ -0,0 +1,61 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include "wayarena.h"
+
+/* XXX: Results of the last few runs of one algorithm. A run is the same
+ * when graph version, endpoints, order and settings are the same, so its
+ * result can be applied again without initGraph() and a search. */
+
+typedef struct
+{
+    quint64 version;
+    int start;
+    int finish;
+    bool order;
+    QString variant; /* Settings which change the result */
+} cache_key_t;
+
+typedef struct
+{
+    QVector<int> opened;
+    WayArena ways;
+    int explored;
+    /* XXX: Settled distances by id, -1 - not settled */
+    QVector<int> distances;
+    /* XXX: Algorithm specific numbers of the raport */
+    QVector<double> values;
+} algorithm_result_t;
+
+class ResultCache
+{
+    enum
+    {
+      Capacity = 8
+    };
+
+public:
+    ResultCache();
+    ~ResultCache();
+
+    /* XXX: A hit becomes the most recently used entry */
+    bool find(const cache_key_t &key, algorithm_result_t *result);
+    void insert(const cache_key_t &key, const algorithm_result_t &result);
+    void clear();
+    int size() const;
+
+private:
+    static bool equal(const cache_key_t &first, const cache_key_t &second);
+
+private:
+    /* XXX: Most recently used first. Values are implicitly shared, so
+     * copying them in and out costs no deep copy */
+    QList<QPair<cache_key_t, algorithm_result_t> > m_entries;
+};
+
+#endif // RESULTCACHE_H
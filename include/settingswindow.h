@@ -25,6 +25,8 @@ enum AlgorithmID
     BFS,
     DFS,
     Dejikstra,
+    AStar,
+    AlgorithmCount,
     Unknown = -1
 };
 
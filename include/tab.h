@@ -9,21 +9,48 @@
 #include <QPushButton>
 #include <QFileDialog>
 #include <QFile>
+#include <QBuffer>
 #include <QTextStream>
 #include <QRadioButton>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QMessageBox>
 
 #include "settingswindow.h"
+#include "csrgraph.h"
+#include "graphtext.h"
+
+class DejikstraAlgorithm;
+class AStarAlgorithm;
 
 class Tab : public QWidget
 {
     Q_OBJECT
 
+    enum
+    {
+      LayoutLimit = 2000 /* Nodes put on the canvas by default on import */
+    };
+
 public:
      explicit Tab(int type, QWidget *parent = Q_NULLPTR);
      ~Tab();
 
     QRadioButton *getLittleBitRB() const;
     QRadioButton *getBiggestBitRB() const;
+    QComboBox *getHeapCB() const;
+    QCheckBox *getBidirectionalCB() const;
+    QDoubleSpinBox *getAStarScaleSB() const;
+    QCheckBox *getAStarCompareCB() const;
+    QSpinBox *getTimeBudgetSB() const;
+    QCheckBox *getAllPairsCB() const;
+    QCheckBox *getDynamicCB() const;
+    QCheckBox *getHierarchyCB() const;
+    QSpinBox *getLandmarksSB() const;
+    QComboBox *getLandmarkSelectionCB() const;
 
 private:
     void layout();
@@ -33,22 +60,45 @@ private:
     QWidget *createSettingsTab(QWidget *parent, QWidget **settings);
 
 private:
-    void writeGraph(QVector<QVector<int> > graph, QTextStream &stream) const;
+    void writeGraph(const CSRGraph &graph, QTextStream &stream) const;
     void writeUIConf(QString filename) const;
     void readUIConf(QString filename, QTextStream &stream) const;
-    void readGraph(QString filename) const;
+    void readText(QString filename, GraphText::Format format) const;
+    void importGraph(QString filename, GraphText::Format format);
+    /* XXX: Grid layout for a graph that comes without one */
+    void placeNodes(int count) const;
+    void writeBinary(QString filename) const;
+    void readBinary(QString filename) const;
     void writeNodeToolTips(QString filename) const;
     QVector<QString> readNodeToolTips(QString filename) const;
+    /* XXX: Settings tab of the settings window, if it was ever opened */
+    Tab *settingsTab() const;
+    /* XXX: Algorithms whose preprocessing the settings ask to save */
+    DejikstraAlgorithm *hierarchyToSave() const;
+    AStarAlgorithm *landmarksToSave() const;
+    /* XXX: .ch and .lmk files next to a text graph of older saves */
+    void readPreprocessing(QString filename) const;
 
 private slots:
     void download();
     void upload();
+    void batch();
 
 private:
     QListWidget *m_list;
     QWidget *m_storage;
     QWidget *m_settings;
     QRadioButton *m_little_bit, *m_biggest_bit;
+    QComboBox *m_heaps;
+    QCheckBox *m_bidirectional;
+    QDoubleSpinBox *m_astar_scale;
+    QCheckBox *m_astar_compare;
+    QSpinBox *m_budget;
+    QCheckBox *m_all_pairs;
+    QCheckBox *m_dynamic;
+    QCheckBox *m_hierarchy;
+    QSpinBox *m_landmarks;
+    QComboBox *m_landmark_selection;
 };
 
 #endif // TAB_H
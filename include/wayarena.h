@@ -0,0 +1,37 @@
+#ifndef WAYARENA_H
+#define WAYARENA_H
+
+#include <QVector>
+
+/* XXX: Ways found by one run, packed in a single buffer.
+ * Way i is m_nodes[m_offsets[i] .. m_offsets[i + 1]). clear() keeps the
+ * storage, so dropping a run is one reset and no per-way allocation. */
+
+class WayArena
+{
+public:
+    WayArena();
+    ~WayArena();
+
+    void clear();
+    int size() const;
+    bool isEmpty() const;
+
+    /* XXX: A way is built at the tail of the buffer between openWay()
+     * and closeWay(), dropWay() throws it away */
+    void openWay();
+    void pushNode(int node);
+    void reverseOpenWay();
+    void closeWay();
+    void dropWay();
+
+    int length(int way) const;
+    const int *nodes(int way) const;
+    QVector<int> way(int way) const;
+
+private:
+    QVector<int> m_nodes;
+    QVector<int> m_offsets;
+};
+
+#endif // WAYARENA_H
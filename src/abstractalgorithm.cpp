@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
 #include "abstractalgorithm.h"
 #include "settingswindow.h"
 
@@ -10,164 +14,265 @@ code2color_t code2color_arr[] = {
 
 AbstractAlgorithm::AbstractAlgorithm(QObject *parent)
     : QObject(parent),
-      m_graph(0),
-      m_debug(0),
-      m_way(0),
-      m_shortest(nullptr)
+      m_parent(-1),
+      m_raport(0),
+      m_shortest(INF),
+      m_reverse_parent(-1),
+      m_bidirectional(false),
+      m_explored(0),
+      m_positions(0),
+      m_cancel(0),
+      m_budget(0),
+      m_steps(0),
+      m_next_poll(PollSteps),
+      m_stopped(false),
+      m_timed_out(false),
+      m_start(-1),
+      m_painted(0),
+      m_paint_pending(false),
+      m_version(NoVersion)
 {
-    MainWindow *sender = qobject_cast<MainWindow*> (parent);
-
-    if (!sender)
-    {
-        LOG_DEBUG("Invalid pointer");
-    }
-    else
-        connect(sender, SIGNAL(execute()), this, SLOT(run()));
+    /* XXX: MainWindow connects its execute() to run() of the selected
+     * algorithm only, all of them are kept alive between runs */
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(finished()));
 }
 
 AbstractAlgorithm::~AbstractAlgorithm()
 {
-    clearWay();
+    /* XXX: Worker uses our members, stop it before they go away */
+    cancel();
+    m_watcher.waitForFinished();
 }
 
-bool AbstractAlgorithm::resizeGraph(GraphicsView *view)
+void AbstractAlgorithm::initGraph()
 {
-    int size;
+    bool debug  = true;
+    GraphicsView *view = MainWindow::instance().getView();
 
     if (!view)
-        LOG_EXIT("Invalid pointer", false);
+        LOG_EXIT("Invalid pointer", );
 
-    if (!(size = view->getNodes().size()))
-        LOG_EXIT("Invalid size", false);
+    if (!view->getModel().nodeCount())
+        LOG_EXIT("Invalid size", );
 
-    for(int i=0; i<size; i++)
-        m_graph.push_back(QVector<int>(size, 0));
+    /* XXX: Unchanged graph keeps its reverse too */
+    if (m_version == view->getModel().version())
+        return;
 
-    return true;
+    /* XXX: Shared copies, the model detaches on its next edit */
+    m_graph = view->getModel().toCSR();
+    m_reverse = view->getModel().reverse();
+    m_positions = view->getModel().positions();
+    m_version = view->getModel().version();
+
+    if (debug)
+        debugGraph();
 }
 
-void AbstractAlgorithm::initGraph()
+void AbstractAlgorithm::setGraph(const CSRGraph &graph)
 {
-    QVector<Node*> nodes;
-    bool debug  = true;
-    GraphicsView *view = MainWindow::instance().getView();
+    m_graph = graph;
+    m_reverse.clear();
+    m_version = NoVersion;
+}
 
-    if (!view)
-        LOG_EXIT("Invalid pointer", );
+void AbstractAlgorithm::setPositions(const QVector<QPointF> &positions)
+{
+    m_positions = positions;
+}
 
-    nodes = view->getNodes();
-    resizeGraph(view);
+const CSRGraph &AbstractAlgorithm::getGraph() const
+{
+    return m_graph;
+}
 
-    for(int i=0; i<nodes.size(); i++)
+bool AbstractAlgorithm::execute(int start, int finish, bool order)
+{
+    m_raport.clear();
+    m_ways.clear();
+    m_explored = 0;
+    m_steps = 0;
+    m_next_poll = PollSteps;
+    m_stopped = false;
+    m_timed_out = false;
+    m_cancel.store(0);
+    m_timer.start();
+
+    if (start < 0 || start >= m_graph.size() ||
+         finish < 0 || finish >= m_graph.size())
     {
-        int name = nodes[i]->text().toInt() - 1;
-        QVector<Edge*> *edges = nodes[i]->getEdges();
+        LOG_EXIT("Invalid parameter:" << start << finish, false);
+    }
 
-        if (name >= nodes.size() || name < 0)
-            LOG_EXIT("Invalid node name:" << name, );
+    m_parent.reset(m_graph.size());
+    m_reverse_parent.reset(m_graph.size());
+    m_shortest.reset(m_graph.size());
 
-        for(int j=0; j<edges->size(); j++)
-        {
-            int connected;
-            QPair<Node*, Node*> vertices = (*edges)[j]->getVertices();
-
-            if (vertices.first == nodes[i])
-                connected = vertices.second->text().toInt();
-            else if (vertices.second == nodes[i])
-                connected = vertices.first->text().toInt();
-            else
-                LOG_EXIT("Invalid node", );
-
-            --connected;
-            m_graph[name][connected] = (*edges)[j]->isWeighted() ?
-               (*edges)[j]->getWeight() : 1;
-        }
-    }
+    /* XXX: Search from finish walks arcs backwards */
+    if (m_bidirectional)
+        reverseGraph();
 
-    if (debug)
-        debugGraph();
+    /* XXX: Partial result of a stopped search isn't an answer */
+    return algorithm(start, finish, order) && !m_stopped;
 }
 
-QVector<QVector<int> > AbstractAlgorithm::getGraph() const
+QVector<int> AbstractAlgorithm::getOpened() const
 {
-    return m_graph;
+    return m_raport;
+}
+
+QVector<QVector<int> > AbstractAlgorithm::getWays() const
+{
+    QVector<QVector<int> > ways;
+
+    for(int i=0; i<m_ways.size(); i++)
+        ways.push_back(m_ways.way(i));
+
+    return ways;
+}
+
+void AbstractAlgorithm::setBidirectional(bool bidirectional)
+{
+    m_bidirectional = bidirectional;
+}
+
+int AbstractAlgorithm::getExplored() const
+{
+    return m_explored;
+}
+
+void AbstractAlgorithm::setTimeBudget(int msec)
+{
+    m_budget = msec < 0 ? 0 : msec;
+}
+
+bool AbstractAlgorithm::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+bool AbstractAlgorithm::isCancelled() const
+{
+    return m_stopped && !m_timed_out;
+}
+
+bool AbstractAlgorithm::isTimedOut() const
+{
+    return m_timed_out;
+}
+
+void AbstractAlgorithm::cancel()
+{
+    m_cancel.store(1);
+}
+
+bool AbstractAlgorithm::interrupted(int steps)
+{
+    if (m_stopped)
+        return true;
+
+    if ((m_steps += steps) < m_next_poll)
+        return false;
+
+    m_next_poll = m_steps + PollSteps;
+
+    if (m_cancel.load())
+        m_stopped = true;
+    else if (m_budget && m_timer.elapsed() > m_budget)
+        m_stopped = m_timed_out = true;
+    else
+        emit progress(qMin(m_steps, m_graph.size()), m_graph.size());
+
+    return m_stopped;
 }
 
 void AbstractAlgorithm::debugGraph()
 {
-    qDebug() << m_graph;
+    qDebug() << "Graph: nodes" << m_graph.size() << "arcs" << m_graph.arcCount();
 }
 
-int AbstractAlgorithm::getIndex(int val) const
+bool AbstractAlgorithm::pushParents(const EpochArray &parent, int from,
+  int to)
 {
-    for(int i=0; i<m_way.size(); i++)
+    int count = 0;
+
+    /* XXX: A way can't be longer than the number of nodes, so a broken
+     * parent chain can't loop forever */
+    for(int node = from; node != -1 && count <= m_graph.size();
+        node = parent.value(node), count++)
     {
-        if (val == m_way[i]->id)
-            return i;
+        m_ways.pushNode(node);
+
+        if (node == to)
+            return true;
     }
 
-    return -1;
+    m_ways.dropWay();
+
+    LOG_EXIT("Broken parent chain", false);
 }
 
-void AbstractAlgorithm::checkBranch(QVector<int> &marked, Node *finish,
- GraphicsView *view)
+bool AbstractAlgorithm::addWay(int start, int finish)
 {
-    int index;
-    Node *n1, *n2;
+    /* XXX: Walk parents back from finish, then turn the way around */
+    m_ways.openWay();
 
-    if (marked.isEmpty())
-        LOG_EXIT("Empty array", );
+    if (!pushParents(m_parent, finish, start))
+        return false;
 
-    /* get index of value for m_way array */
-    if ((index = getIndex(marked.back())) == -1)
-        LOG_EXIT("Invalid index", );
+    m_ways.reverseOpenWay();
+    m_ways.closeWay();
 
-    if(!(n1 = view->findNodeByIndex(marked.back())))
-        LOG_EXIT("Invalid pointer", );
+    return true;
+}
 
-    if (n1->findConnectedEdge(finish))
-        return;
+bool AbstractAlgorithm::addMeetWay(int start, int from, int to, int finish)
+{
+    m_ways.openWay();
 
-    for(int i=index + 1; i<m_way.size(); i++)
-    {
-        if (!(n2 = view->findNodeByIndex(m_way[i]->id)))
-            LOG_EXIT("Invalid pointer", );
+    if (!pushParents(m_parent, from, start))
+        return false;
 
-        if (!m_way[i]->visited && n1->findConnectedEdge(n2))
-        {
-            marked.push_back(m_way[i]->id);
-            m_way[i]->visited = true;
-            checkBranch(marked, finish, view);
-            return;
-        }
-    }
+    m_ways.reverseOpenWay();
+
+    /* XXX: Second half goes by parents of the search from finish */
+    if (!pushParents(m_reverse_parent, to, finish))
+        return false;
+
+    m_ways.closeWay();
+
+    return true;
+}
+
+const CSRGraph &AbstractAlgorithm::reverseGraph()
+{
+    if (m_reverse.size() != m_graph.size())
+        m_reverse = m_graph.reversed();
 
-    marked.pop_back();
-    checkBranch(marked, finish, view);
+    return m_reverse;
 }
 
-void AbstractAlgorithm::markEdge(QVector<int> marked, Node *finish,
- GraphicsView *view, bool reset)
+quint64 AbstractAlgorithm::graphVersion() const
+{
+    return m_version;
+}
+
+void AbstractAlgorithm::markEdge(int index, GraphicsView *view, int code)
 {
     Edge *edge;
     Node *n1, *n2;
-    static int code = 0;
+    const int *way = m_ways.nodes(index);
 
-    if (marked.isEmpty())
+    if (m_ways.length(index) < 2)
         LOG_EXIT("Array is empty", );
 
-    if (reset)
-        code = 0;
-
-    for(int i=0; i<marked.size(); i++)
+    for(int i=0; i<m_ways.length(index) - 1; i++)
     {
-        if(!(n1 = view->findNodeByIndex(marked[i])))
-            LOG_EXIT("Invalid pointer", );
-
-        if ((i + 1) == marked.size())
-            n2 = finish;
-        else if (!(n2 = view->findNodeByIndex(marked[i + 1])))
+        if(!(n1 = view->findNodeByIndex(way[i])) ||
+           !(n2 = view->findNodeByIndex(way[i + 1])))
+        {
             LOG_EXIT("Invalid pointer", );
+        }
 
         if (!(edge = n1->findConnectedEdge(n2)))
             LOG_EXIT("Invalid pointer", );
@@ -175,57 +280,153 @@ void AbstractAlgorithm::markEdge(QVector<int> marked, Node *finish,
         if (edge->pen().color() == Qt::white)
             edge->setPen(QPen(code2color(code), 1.5, Qt::SolidLine));
     }
+}
+
+QVector<int> AbstractAlgorithm::toNames(QVector<int> ids) const
+{
+    for(int i=0; i<ids.size(); i++)
+        ids[i]++;
+
+    return ids;
+}
+
+void AbstractAlgorithm::apply(GraphicsView *view, int start)
+{
+    Raport *raport;
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    /* Mark opened nodes until not found connected one */
+    m_start = start;
+    m_opened = m_raport;
+    m_painted = 0;
+
+    /* XXX: A batch already queued carries on with the new list, a second
+     * chain would paint it twice */
+    if (!m_paint_pending)
+        paintOpened();
+
+    for(int i=0; i<m_ways.size(); i++)
+        markEdge(i, view, i);
+
+    MainWindow::instance().createRaport();
 
-    code++;
+    if (!(raport = MainWindow::instance().getRaport()))
+        LOG_EXIT("Invalid pointer", );
+
+    raport->setRaport(toNames(m_raport));
+
+    for(int i=0; i<m_ways.size(); i++)
+        raport->appendRaport(toNames(m_ways.way(i)), "Way: ");
+
+    raport->appendRaport(QString("Explored: %1%2").arg(m_explored)
+      .arg(m_bidirectional ? " (bidirectional)" : ""));
 }
 
-QVector<int> AbstractAlgorithm::markWay(GraphicsView *view,
-  Node *finish, bool reset)
+void AbstractAlgorithm::paintOpened()
 {
-    QVector<int> marked;
+    GraphicsView *view = MainWindow::instance().getView();
+    int last = qMin(m_painted + (int) PaintBatch, m_opened.size());
+
+    m_paint_pending = false;
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    for(; m_painted<last; m_painted++)
+    {
+        Node *node;
 
-    if (m_way.isEmpty())
-        LOG_EXIT("Array is empty", QVector<int>());
+        if (m_opened[m_painted] == m_start)
+            continue;
 
-    marked.push_back(m_way[0]->id);
-    checkBranch(marked, finish, view);
-    markEdge(marked, finish, view, reset);
-    clearWay();
+        if (!(node = view->findNodeByIndex(m_opened[m_painted])))
+            LOG_EXIT("Node doesn't exist", );
 
-    return marked;
+        node->setBrush(QBrush(Qt::yellow, Qt::SolidPattern));
+    }
+
+    /* XXX: Let the event loop breathe between batches on big graphs */
+    if (m_painted < m_opened.size())
+    {
+        m_paint_pending = true;
+        QTimer::singleShot(0, this, SLOT(paintOpened()));
+    }
 }
 
-void AbstractAlgorithm::clearWay()
+void AbstractAlgorithm::configure(Tab *tab)
 {
-    for(int i=0; i<m_way.size(); i++)
+    QCheckBox *box;
+    QSpinBox *budget;
+
+    if (tab && (box = tab->getBidirectionalCB()))
+        m_bidirectional = box->isChecked();
+
+    if (tab && (budget = tab->getTimeBudgetSB()))
+        setTimeBudget(budget->value());
+}
+
+bool AbstractAlgorithm::select(GraphicsView *view, int *start, int *finish)
+{
+    Node *first, *last;
+
+    if (!(first = view->getStartNode()) ||
+         !(last = view->getFinishNode()) || (first == last))
     {
-        if (m_way[i])
-            delete m_way[i];
+        MainWindow::instance().showMessage("Select start and end node!");
+        LOG_EXIT("Invalid pointer", false);
     }
 
-    m_way.clear();
+    *start = first->index();
+    *finish = last->index();
+
+    return true;
+}
+
+bool AbstractAlgorithm::cacheable() const
+{
+    return true;
+}
+
+QString AbstractAlgorithm::variant() const
+{
+    return QString("bidirectional=%1").arg((int) m_bidirectional);
+}
+
+void AbstractAlgorithm::saveResult(algorithm_result_t *result) const
+{
+    result->opened = m_raport;
+    result->ways = m_ways;
+    result->explored = m_explored;
+}
+
+void AbstractAlgorithm::loadResult(const algorithm_result_t &result)
+{
+    m_raport = result.opened;
+    m_ways = result.ways;
+    m_explored = result.explored;
 }
 
 void AbstractAlgorithm::run()
 {
     SettingsWindow *s;
     Tab *tab;
-    Node *start, *finish;
+    algorithm_result_t cached;
+    int start, finish;
     GraphicsView *view = MainWindow::instance().getView();
     bool order = true;
 
     if (!view)
         LOG_EXIT("Invalid pointer", );
 
-    start = view->getStartNode();
-    finish = view->getFinishNode();
+    /* XXX: Settings are plain members the worker reads, a live search
+     * keeps the ones it started with */
+    if (isRunning())
+        LOG_EXIT("Already running", );
 
-    if (!(start = view->getStartNode()) ||
-         !(finish = view->getFinishNode()) || (start == finish))
-    {
-        MainWindow::instance().showMessage("Select start and end node!");
-        LOG_EXIT("Invalid pointer", );
-    }
+    if (!select(view, &start, &finish))
+        LOG_EXIT("Nothing to search", );
 
     if ((s = MainWindow::instance().getSettingsWindow()) &&
          (tab = s->getSettingsTab()))
@@ -237,14 +438,69 @@ void AbstractAlgorithm::run()
 
         if ((btn = tab->getBiggestBitRB()) && btn->isChecked())
             order = false;
+
+        configure(tab);
+    }
+
+    m_key.version = view->getModel().version();
+    m_key.start = start;
+    m_key.finish = finish;
+    m_key.order = order;
+    m_key.variant = variant();
+
+    /* XXX: Same query on the same graph, show it again */
+    if (cacheable() && m_cache.find(m_key, &cached))
+    {
+        loadResult(cached);
+        apply(view, start);
+        return;
     }
 
-    m_graph.clear();
-    m_list.clear();
-    m_debug.clear();
+    /* XXX: Painting of the last result stops, a queued batch finds
+     * nothing left */
+    m_opened.clear();
+    m_painted = 0;
 
+    /* XXX: Worker gets a snapshot, the scene may change meanwhile */
     initGraph();
-    algorithm(start, finish, view, order);
+    m_start = start;
+
+    MainWindow::instance().showProgress(this);
+    m_watcher.setFuture(QtConcurrent::run(this, &AbstractAlgorithm::execute,
+      m_start, finish, order));
+}
+
+void AbstractAlgorithm::finished()
+{
+    GraphicsView *view = MainWindow::instance().getView();
+
+    emit stopped();
+
+    /* XXX: Replaced by another algorithm, nobody waits for this result */
+    if (MainWindow::instance().currentAlgorithm() != this)
+        return;
+
+    if (isCancelled())
+        MainWindow::instance().showMessage("Search cancelled!");
+    else if (isTimedOut())
+    {
+        MainWindow::instance().showMessage(
+          QString("Time budget of %1 ms exceeded!").arg(m_budget));
+    }
+    else if (m_watcher.result())
+    {
+        if (cacheable())
+        {
+            algorithm_result_t result;
+
+            saveResult(&result);
+            m_cache.insert(m_key, result);
+        }
+
+        apply(view, m_start);
+    }
+    else
+        MainWindow::instance().showMessage("Solution not found!");
 }
 
 Qt::GlobalColor code2color(const int code)
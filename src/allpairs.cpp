@@ -0,0 +1,362 @@
+#include <climits>
+#include <cstring>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include "allpairs.h"
+#include "log.h"
+
+#ifndef INF
+#define INF INT32_MAX
+#endif
+
+AllPairs::AllPairs(const CSRGraph &graph)
+    : m_graph(graph),
+      m_chosen(Auto)
+{
+
+}
+
+AllPairs::~AllPairs()
+{
+
+}
+
+AllPairs::Method AllPairs::chosen() const
+{
+    return m_chosen;
+}
+
+QString AllPairs::methodName(Method method)
+{
+    switch(method)
+    {
+        case FloydWarshall:
+        return "Floyd-Warshall (blocked)";
+
+        case RepeatedDejikstra:
+        return "Dejikstra from every node";
+
+        default:
+        return "Auto";
+    }
+}
+
+AllPairs::Method AllPairs::choose() const
+{
+    qint64 size = m_graph.size();
+
+    /* XXX: n^3 of tight tile loops beats n heap runs only when there are
+     * about as many arcs as pairs */
+    if (size <= FloydLimit && m_graph.arcCount() * DenseRatio >= size * size)
+        return FloydWarshall;
+
+    return RepeatedDejikstra;
+}
+
+bool AllPairs::writeHeader(QFile &file) const
+{
+    matrix_header_t header;
+
+    memcpy(header.magic, MATRIX_MAGIC, sizeof(header.magic));
+    header.version = MATRIX_VERSION;
+    header.size = m_graph.size();
+    header.reserved = 0;
+
+    return file.write((const char*) &header, sizeof(header)) == sizeof(header);
+}
+
+bool AllPairs::write(QString filename, Method method,
+  std::function<bool(int)> stop)
+{
+    QFile file(filename);
+    bool result;
+
+    if (m_graph.isEmpty())
+        LOG_EXIT("Graph is empty", false);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        LOG_EXIT("Can't open file:" << filename, false);
+
+    if (!writeHeader(file))
+        LOG_EXIT("Can't write file:" << filename, false);
+
+    m_chosen = (method == Auto) ? choose() : method;
+
+    if (m_chosen == FloydWarshall)
+        result = floydWarshall(file, stop);
+    else
+        result = repeatedDejikstra(file, stop);
+
+    file.close();
+
+    /* XXX: Half written matrix is worse than none */
+    if (!result)
+        file.remove();
+
+    return result;
+}
+
+void AllPairs::relaxTile(qint32 *dist, int ib, int jb, int kb) const
+{
+    int size = m_graph.size();
+    int i_end = qMin(ib + (int) Tile, size);
+    int j_end = qMin(jb + (int) Tile, size);
+    int k_end = qMin(kb + (int) Tile, size);
+
+    /* XXX: k outermost, so a tile depending on itself (diagonal, row or
+     * column of the k block) sees its own updates in the right order */
+    for(int k=kb; k<k_end; k++)
+    {
+        const qint32 *row_k = dist + (qint64) k * size;
+
+        for(int i=ib; i<i_end; i++)
+        {
+            qint32 *row_i = dist + (qint64) i * size;
+            qint32 ik = row_i[k];
+
+            if (ik == INF)
+                continue;
+
+            for(int j=jb; j<j_end; j++)
+            {
+                if (row_k[j] != INF && ik + row_k[j] < row_i[j])
+                    row_i[j] = ik + row_k[j];
+            }
+        }
+    }
+}
+
+bool AllPairs::floydWarshall(QFile &file, std::function<bool(int)> stop)
+{
+    int size = m_graph.size();
+    QVector<qint32> matrix((qint64) size * size, INF);
+    QVector<int> blocks;
+    qint32 *dist = matrix.data();
+
+    for(int i=0; i<size; i++)
+    {
+        const int *adj = m_graph.neighbors(i);
+        const int *weights = m_graph.weights(i);
+
+        for(int k=0; k<m_graph.degree(i); k++)
+            dist[(qint64) i * size + adj[k]] = weights[k];
+
+        /* XXX: After the arcs, a self loop of a matrix import is no way
+         * to itself, repeated Dejikstra says 0 there too */
+        dist[(qint64) i * size + i] = 0;
+    }
+
+    for(int b=0; b<size; b += Tile)
+        blocks.push_back(b);
+
+    for(int kb=0; kb<size; kb += Tile)
+    {
+        if (stop && stop(qMin((int) Tile, size - kb)))
+            return false;
+
+        /* Phase 1: the diagonal tile */
+        relaxTile(dist, kb, kb, kb);
+
+        /* Phase 2: row and column of the k block, they read phase 1 only */
+        QtConcurrent::blockingMap(blocks, [&](int &b)
+        {
+            if (b == kb)
+                return;
+
+            relaxTile(dist, kb, b, kb);
+            relaxTile(dist, b, kb, kb);
+        });
+
+        /* Phase 3: everything else, one row of tiles per task */
+        QtConcurrent::blockingMap(blocks, [&](int &ib)
+        {
+            if (ib == kb)
+                return;
+
+            for(int jb=0; jb<size; jb += Tile)
+            {
+                if (jb != kb)
+                    relaxTile(dist, ib, jb, kb);
+            }
+        });
+    }
+
+    for(qint64 i=0; i<matrix.size(); i++)
+    {
+        if (dist[i] == INF)
+            dist[i] = -1;
+    }
+
+    return file.write((const char*) dist, matrix.size() * sizeof(qint32)) ==
+      (qint64) (matrix.size() * sizeof(qint32));
+}
+
+void AllPairs::dejikstraRow(apsp_chunk_t &chunk, int source) const
+{
+    int size = m_graph.size();
+    qint32 *row = chunk.rows.data() + (qint64) (source - chunk.begin) * size;
+
+    std::fill(row, row + size, INF);
+    chunk.heap.clear();
+    chunk.heap.reserve(size);
+
+    row[source] = 0;
+    chunk.heap.push(0, source);
+
+    while(!chunk.heap.isEmpty())
+    {
+        int key, current;
+        const int *adj, *weights;
+
+        chunk.heap.pop(&key, &current);
+
+        /* Stale entry, node was reached by a shorter way already */
+        if (key > row[current])
+            continue;
+
+        adj = m_graph.neighbors(current);
+        weights = m_graph.weights(current);
+
+        for(int k=0; k<m_graph.degree(current); k++)
+        {
+            if (key + weights[k] < row[adj[k]])
+            {
+                row[adj[k]] = key + weights[k];
+                chunk.heap.push(row[adj[k]], adj[k]);
+            }
+        }
+    }
+
+    for(int i=0; i<size; i++)
+    {
+        if (row[i] == INF)
+            row[i] = -1;
+    }
+}
+
+bool AllPairs::repeatedDejikstra(QFile &file, std::function<bool(int)> stop)
+{
+    int size = m_graph.size();
+    int tasks = qMax(1, QThread::idealThreadCount());
+    QVector<apsp_chunk_t> chunks(tasks);
+
+    /* XXX: Rows go to the file a batch at a time, in source order, so
+     * memory stays at Batch rows whatever the graph size */
+    for(int begin=0; begin<size; begin += Batch)
+    {
+        int end = qMin(begin + (int) Batch, size);
+        int step = (end - begin + tasks - 1) / tasks;
+
+        if (stop && stop(end - begin))
+            return false;
+
+        for(int c=0; c<tasks; c++)
+        {
+            chunks[c].begin = qMin(begin + c * step, end);
+            chunks[c].end = qMin(chunks[c].begin + step, end);
+            chunks[c].rows.resize((chunks[c].end - chunks[c].begin) * size);
+        }
+
+        QtConcurrent::blockingMap(chunks, [&](apsp_chunk_t &chunk)
+        {
+            for(int s=chunk.begin; s<chunk.end; s++)
+                dejikstraRow(chunk, s);
+        });
+
+        for(int c=0; c<tasks; c++)
+        {
+            qint64 bytes = chunks[c].rows.size() * sizeof(qint32);
+
+            if (file.write((const char*) chunks[c].rows.constData(), bytes) !=
+                 bytes)
+            {
+                LOG_EXIT("Can't write file:" << file.fileName(), false);
+            }
+        }
+    }
+
+    return true;
+}
+
+DistanceMatrix::DistanceMatrix()
+    : m_size(0),
+      m_row_id(-1),
+      m_row(0)
+{
+
+}
+
+DistanceMatrix::~DistanceMatrix()
+{
+    close();
+}
+
+bool DistanceMatrix::open(QString filename)
+{
+    matrix_header_t header;
+
+    close();
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QIODevice::ReadOnly))
+        LOG_EXIT("Can't open file:" << filename, false);
+
+    if (m_file.read((char*) &header, sizeof(header)) != sizeof(header) ||
+         memcmp(header.magic, MATRIX_MAGIC, sizeof(header.magic)) ||
+         header.version != MATRIX_VERSION || header.size <= 0 ||
+         m_file.size() != (qint64) sizeof(header) +
+           (qint64) header.size * header.size * (qint64) sizeof(qint32))
+    {
+        m_file.close();
+        LOG_EXIT("Invalid matrix file:" << filename, false);
+    }
+
+    m_size = header.size;
+
+    return true;
+}
+
+void DistanceMatrix::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_size = 0;
+    m_row_id = -1;
+    m_row.clear();
+}
+
+bool DistanceMatrix::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+int DistanceMatrix::size() const
+{
+    return m_size;
+}
+
+int DistanceMatrix::distance(int from, int to)
+{
+    qint64 bytes = (qint64) m_size * sizeof(qint32);
+
+    if (from < 0 || from >= m_size || to < 0 || to >= m_size)
+        LOG_EXIT("Invalid parameter:" << from << to, -1);
+
+    if (from != m_row_id)
+    {
+        m_row.resize(m_size);
+
+        if (!m_file.seek(sizeof(matrix_header_t) + from * bytes) ||
+             m_file.read((char*) m_row.data(), bytes) != bytes)
+        {
+            m_row_id = -1;
+            LOG_EXIT("Can't read row:" << from, -1);
+        }
+
+        m_row_id = from;
+    }
+
+    return m_row[to];
+}
@@ -0,0 +1,394 @@
+#include <cmath>
+
+#include "astaralgorithm.h"
+#include "heap.h"
+
+AStarAlgorithm::AStarAlgorithm(QObject *parent)
+    : AbstractAlgorithm(parent),
+      m_scale(1.0),
+      m_used_scale(1.0),
+      m_safe_scale(-1),
+      m_safe_version(NoVersion),
+      m_compare(false),
+      m_dijkstra_explored(-1),
+      m_settled(0),
+      m_landmarks_version(NoVersion),
+      m_landmark_count(0),
+      m_selection(Landmarks::Farthest),
+      m_landmarks_built(false)
+{
+
+}
+
+AStarAlgorithm::~AStarAlgorithm()
+{
+
+}
+
+void AStarAlgorithm::setScale(double scale)
+{
+    m_scale = scale < 0 ? 0 : scale;
+}
+
+void AStarAlgorithm::setCompare(bool compare)
+{
+    m_compare = compare;
+}
+
+int AStarAlgorithm::getDijkstraExplored() const
+{
+    return m_dijkstra_explored;
+}
+
+void AStarAlgorithm::setLandmarks(int count, Landmarks::Selection selection)
+{
+    m_landmark_count = qBound(0, count, (int) Landmarks::MaxCount);
+    m_selection = selection;
+}
+
+bool AStarAlgorithm::landmarksStale(const CSRGraph &graph,
+  quint64 version) const
+{
+    return version == NoVersion || m_landmarks_version != version ||
+      m_landmarks.size() != graph.size() || m_landmarks.selection() !=
+      m_selection || m_landmarks.count() != qMin(m_landmark_count,
+      graph.size());
+}
+
+bool AStarAlgorithm::saveLandmarks(QIODevice *device, const CSRGraph *graph)
+{
+    Landmarks landmarks;
+    GraphicsView *view = MainWindow::instance().getView();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", false);
+
+    if (isRunning() || m_landmark_count <= 0)
+        LOG_EXIT("Can't save landmarks now", false);
+
+    if (graph)
+    {
+        if (!landmarks.build(*graph, m_landmark_count, m_selection, nullptr))
+            LOG_EXIT("Can't compute landmarks", false);
+
+        return landmarks.save(device);
+    }
+
+    if (landmarksStale(view->getModel().graph(), view->getModel().version()))
+    {
+        if (!m_landmarks.build(view->getModel().graph(), m_landmark_count,
+               m_selection, nullptr))
+        {
+            LOG_EXIT("Can't compute landmarks", false);
+        }
+
+        m_landmarks_version = view->getModel().version();
+    }
+
+    return m_landmarks.save(device);
+}
+
+bool AStarAlgorithm::loadLandmarks(QIODevice *device)
+{
+    GraphicsView *view = MainWindow::instance().getView();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", false);
+
+    if (isRunning())
+        LOG_EXIT("Already running", false);
+
+    /* XXX: Data of another graph is rejected, the next run computes */
+    if (!m_landmarks.load(device, view->getModel().graph()))
+    {
+        m_landmarks_version = NoVersion;
+        return false;
+    }
+
+    m_landmarks_version = view->getModel().version();
+
+    return true;
+}
+
+bool AStarAlgorithm::prepareLandmarks()
+{
+    m_landmarks_built = landmarksStale(m_graph, graphVersion());
+
+    if (!m_landmarks_built)
+        return true;
+
+    if (!m_landmarks.build(m_graph, m_landmark_count, m_selection,
+           [this](int steps) { return interrupted(steps); }))
+    {
+        m_landmarks_version = NoVersion;
+        return false;
+    }
+
+    m_landmarks_version = graphVersion();
+
+    return true;
+}
+
+void AStarAlgorithm::configure(Tab *tab)
+{
+    QDoubleSpinBox *scale;
+    QCheckBox *compare;
+    QSpinBox *landmarks;
+    QComboBox *selection;
+
+    AbstractAlgorithm::configure(tab);
+
+    /* XXX: Single direction only, the heuristic aims at finish */
+    m_bidirectional = false;
+
+    if (tab && (scale = tab->getAStarScaleSB()))
+        setScale(scale->value());
+
+    if (tab && (compare = tab->getAStarCompareCB()))
+        m_compare = compare->isChecked();
+
+    if (tab && (landmarks = tab->getLandmarksSB()) &&
+         (selection = tab->getLandmarkSelectionCB()))
+    {
+        setLandmarks(landmarks->value(),
+          (Landmarks::Selection) selection->currentIndex());
+    }
+}
+
+QString AStarAlgorithm::variant() const
+{
+    return AbstractAlgorithm::variant() +
+      QString(" scale=%1 landmarks=%2/%3 compare=%4").arg(m_scale)
+      .arg(m_landmark_count).arg(m_selection).arg(m_compare);
+}
+
+void AStarAlgorithm::saveResult(algorithm_result_t *result) const
+{
+    AbstractAlgorithm::saveResult(result);
+
+    result->distances.fill(-1, m_graph.size());
+    result->values.clear();
+    result->values << m_used_scale << m_dijkstra_explored;
+
+    for(int i=0; i<m_graph.size(); i++)
+    {
+        if (m_settled.contains(i))
+            result->distances[i] = m_shortest.value(i);
+    }
+}
+
+void AStarAlgorithm::loadResult(const algorithm_result_t &result)
+{
+    AbstractAlgorithm::loadResult(result);
+
+    if (result.values.size() == 2)
+    {
+        m_used_scale = result.values[0];
+        m_dijkstra_explored = (int) result.values[1];
+    }
+
+    m_landmarks_built = false;
+
+    m_settled.reset(result.distances.size());
+    m_shortest.reset(result.distances.size());
+
+    for(int i=0; i<result.distances.size(); i++)
+    {
+        if (result.distances[i] < 0)
+            continue;
+
+        m_settled.set(i, 1);
+        m_shortest.set(i, result.distances[i]);
+    }
+}
+
+double AStarAlgorithm::length(int first, int second) const
+{
+    QPointF delta;
+
+    if (first >= m_positions.size() || second >= m_positions.size())
+        return 0;
+
+    delta = m_positions[first] - m_positions[second];
+
+    return std::sqrt(delta.x() * delta.x() + delta.y() * delta.y());
+}
+
+double AStarAlgorithm::admissibleScale() const
+{
+    double result = -1;
+
+    /* XXX: scale * length(u, v) <= weight(u, v) on every arc makes the
+     * heuristic consistent, so the first pop of a node is final */
+    for(int i=0; i<m_graph.size(); i++)
+    {
+        const int *adj = m_graph.neighbors(i);
+        const int *weights = m_graph.weights(i);
+
+        for(int k=0; k<m_graph.degree(i); k++)
+        {
+            double len = length(i, adj[k]);
+
+            if (len > 0 && (result < 0 || weights[k] / len < result))
+                result = weights[k] / len;
+        }
+    }
+
+    return result;
+}
+
+double AStarAlgorithm::safeScale()
+{
+    /* XXX: Positions are in the model too, moving a node is an edit. A
+     * graph given by setGraph() has no version, it's scanned every run */
+    if (graphVersion() == NoVersion || m_safe_version != graphVersion())
+    {
+        m_safe_scale = admissibleScale();
+        m_safe_version = graphVersion();
+    }
+
+    return m_safe_scale;
+}
+
+int AStarAlgorithm::estimate(int node, int finish, double scale,
+  bool landmarks) const
+{
+    int result = (int) (scale * length(node, finish));
+
+    if (landmarks)
+        result = qMax(result, m_landmarks.bound(node, finish));
+
+    return result;
+}
+
+bool AStarAlgorithm::search(int start, int finish, double scale,
+  bool landmarks, int *expanded)
+{
+    bool found = false;
+    BinaryHeap &heap = m_heap;
+
+    /* XXX: Called twice by a comparing run, epoch reset is O(1) */
+    *expanded = 0;
+    m_settled.reset(m_graph.size());
+    m_shortest.reset(m_graph.size());
+    m_parent.reset(m_graph.size());
+    m_raport.clear();
+    heap.clear();
+    heap.reserve(m_graph.size());
+
+    m_shortest.set(start, 0);
+    heap.push(estimate(start, finish, scale, landmarks), start);
+
+    while(!heap.isEmpty() && !interrupted())
+    {
+        int key, current;
+        const int *adj, *weights;
+
+        heap.pop(&key, &current);
+
+        if (m_settled.contains(current))
+            continue;
+
+        m_settled.set(current, 1);
+        m_raport.push_back(current);
+        (*expanded)++;
+
+        if (current == finish)
+        {
+            found = true;
+            break;
+        }
+
+        adj = m_graph.neighbors(current);
+        weights = m_graph.weights(current);
+
+        for(int k = 0; k<m_graph.degree(current); k++)
+        {
+            int i = adj[k]; /* connected with i-node */
+            int sum = weights[k] + m_shortest.value(current);
+
+            if (m_settled.contains(i) || sum >= m_shortest.value(i))
+                continue;
+
+            /* XXX: floor() of a consistent heuristic stays consistent
+             * for integer weights */
+            m_shortest.set(i, sum);
+            m_parent.set(i, current);
+            heap.push(sum + estimate(i, finish, scale, landmarks), i);
+        }
+    }
+
+    return found;
+}
+
+bool AStarAlgorithm::algorithm(int start, int finish, bool order)
+{
+    double safe;
+    int expanded;
+
+    /* XXX: Weights and coordinates define the order, not the node ids */
+    Q_UNUSED(order);
+
+    safe = safeScale();
+    m_used_scale = m_scale;
+
+    if (safe >= 0 && m_used_scale > safe)
+    {
+        LOG_DEBUG("Heuristic isn't admissible, scale lowered to" << safe);
+        m_used_scale = safe;
+    }
+
+    m_landmarks_built = false;
+
+    if (m_landmark_count > 0 && !prepareLandmarks())
+        return false;
+
+    /* XXX: Plain Dejikstra run (zero heuristic) only for the comparison */
+    m_dijkstra_explored = -1;
+
+    if (m_compare)
+        search(start, finish, 0, false, &m_dijkstra_explored);
+
+    if (!search(start, finish, m_used_scale, m_landmark_count > 0,
+           &expanded))
+    {
+        return false;
+    }
+
+    m_explored = expanded;
+
+    return addWay(start, finish);
+}
+
+void AStarAlgorithm::apply(GraphicsView *view, int start)
+{
+    Raport *raport;
+    int finish;
+
+    AbstractAlgorithm::apply(view, start);
+
+    if (!(raport = MainWindow::instance().getRaport()) || m_ways.isEmpty())
+        LOG_EXIT("Invalid pointer", );
+
+    finish = m_ways.nodes(0)[m_ways.length(0) - 1];
+
+    raport->appendRaport(QString("Distance: %1").arg(m_shortest.value(finish)));
+    raport->appendRaport(QString("Heuristic scale: %1%2").arg(m_used_scale)
+      .arg(m_used_scale < m_scale ? " (lowered to stay admissible)" : ""));
+    if (m_dijkstra_explored >= 0)
+    {
+        raport->appendRaport(QString("Expanded: A* %1, Dejikstra %2")
+          .arg(m_explored).arg(m_dijkstra_explored));
+    }
+    else
+        raport->appendRaport(QString("Expanded: A* %1").arg(m_explored));
+
+    if (m_landmark_count > 0)
+    {
+        raport->appendRaport(QString("Landmarks: %1, %2%3")
+          .arg(m_landmarks.count())
+          .arg(m_selection == Landmarks::Degree ? "highest degree" :
+               "farthest")
+          .arg(m_landmarks_built ? " (computed by this run)" : ""));
+    }
+}
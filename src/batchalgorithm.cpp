@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include "batchalgorithm.h"
+
+BatchAlgorithm::BatchAlgorithm(QObject *parent)
+    : AbstractAlgorithm(parent)
+{
+
+}
+
+BatchAlgorithm::~BatchAlgorithm()
+{
+
+}
+
+bool BatchAlgorithm::setQueries(const QVector<batch_query_t> &queries)
+{
+    if (isRunning())
+        LOG_EXIT("Already running", false);
+
+    m_queries = queries;
+
+    return true;
+}
+
+const QVector<batch_result_t> &BatchAlgorithm::getResults() const
+{
+    return m_results;
+}
+
+bool BatchAlgorithm::parseQueries(QString text, QVector<batch_query_t> *queries)
+{
+    QStringList lines;
+
+    if (!queries)
+        LOG_EXIT("Invalid pointer", false);
+
+    queries->clear();
+    lines = text.replace(',', '\n').replace(';', '\n').split('\n');
+
+    for(int i=0; i<lines.size(); i++)
+    {
+        QStringList pair;
+        batch_query_t query;
+        bool ok_from, ok_to;
+        QString line = lines[i].simplified();
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        pair = line.split(' ');
+
+        if (pair.size() != 2)
+            LOG_EXIT("Invalid query:" << line, false);
+
+        /* XXX: Names are shown from 1, ids start from 0 */
+        query.from = pair[0].toInt(&ok_from) - 1;
+        query.to = pair[1].toInt(&ok_to) - 1;
+
+        if (!ok_from || !ok_to || query.from < 0 || query.to < 0)
+            LOG_EXIT("Invalid query:" << line, false);
+
+        queries->push_back(query);
+    }
+
+    return !queries->isEmpty();
+}
+
+bool BatchAlgorithm::select(GraphicsView *view, int *start, int *finish)
+{
+    if (m_queries.isEmpty())
+    {
+        MainWindow::instance().showMessage("No queries!");
+        LOG_EXIT("No queries", false);
+    }
+
+    /* XXX: Any valid node, execute() checks them only */
+    *start = *finish = 0;
+
+    return true;
+}
+
+bool BatchAlgorithm::cacheable() const
+{
+    /* XXX: The key has no place for the queries */
+    return false;
+}
+
+void BatchAlgorithm::group()
+{
+    int size = m_graph.size();
+
+    m_order.clear();
+    m_groups.clear();
+
+    /* XXX: Queries with unknown nodes stay without answer */
+    for(int q=0; q<m_queries.size(); q++)
+    {
+        if (m_queries[q].from < size && m_queries[q].to < size)
+            m_order.push_back(q);
+    }
+
+    std::sort(m_order.begin(), m_order.end(), [this](int a, int b)
+    {
+        return m_queries[a].from < m_queries[b].from ||
+          (m_queries[a].from == m_queries[b].from && a < b);
+    });
+
+    for(int j=0; j<m_order.size(); j++)
+    {
+        if (!j || m_queries[m_order[j]].from != m_queries[m_order[j - 1]].from)
+            m_groups.push_back(j);
+    }
+
+    m_groups.push_back(m_order.size());
+}
+
+void BatchAlgorithm::search(batch_chunk_t &chunk, int group,
+  batch_result_t *results)
+{
+    int size = m_graph.size(), remaining = 0;
+    int source = m_queries[m_order[m_groups[group]]].from;
+
+    chunk.distance.reset(size);
+    chunk.parent.reset(size);
+    chunk.target.reset(size);
+    chunk.heap.clear();
+    chunk.heap.reserve(size);
+
+    for(int j=m_groups[group]; j<m_groups[group + 1]; j++)
+    {
+        int to = m_queries[m_order[j]].to;
+
+        if (!chunk.target.contains(to))
+        {
+            chunk.target.set(to, 1);
+            remaining++;
+        }
+    }
+
+    chunk.distance.set(source, 0);
+    chunk.heap.push(0, source);
+
+    /* XXX: Stop as soon as every finish of the group is settled */
+    while(remaining && !chunk.heap.isEmpty())
+    {
+        int key, current;
+        const int *adj, *weights;
+
+        chunk.heap.pop(&key, &current);
+
+        /* Stale entry, node was reached by a shorter way already */
+        if (key > chunk.distance.value(current))
+            continue;
+
+        chunk.explored++;
+
+        if (chunk.target.contains(current))
+            remaining--;
+
+        adj = m_graph.neighbors(current);
+        weights = m_graph.weights(current);
+
+        for(int k=0; k<m_graph.degree(current); k++)
+        {
+            if (key + weights[k] < chunk.distance.value(adj[k]))
+            {
+                chunk.distance.set(adj[k], key + weights[k]);
+                chunk.parent.set(adj[k], current);
+                chunk.heap.push(key + weights[k], adj[k]);
+            }
+        }
+    }
+
+    /* XXX: Every reached finish is settled here, so its distance is final */
+    for(int j=m_groups[group]; j<m_groups[group + 1]; j++)
+    {
+        batch_result_t &result = results[m_order[j]];
+
+        if (!chunk.distance.contains(result.to))
+            continue;
+
+        result.distance = chunk.distance.value(result.to);
+
+        chunk.ways.openWay();
+
+        for(int node = result.to; node != -1; node = chunk.parent.value(node))
+            chunk.ways.pushNode(node);
+
+        chunk.ways.reverseOpenWay();
+        chunk.ways.closeWay();
+        result.way = chunk.ways.size() - 1;
+    }
+}
+
+void BatchAlgorithm::collect(batch_chunk_t &chunk)
+{
+    /* XXX: Ways move to the shared arena in query order of the round */
+    for(int j=m_groups[chunk.begin]; j<m_groups[chunk.end]; j++)
+    {
+        batch_result_t &result = m_results[m_order[j]];
+        const int *way;
+
+        if (result.way == -1)
+            continue;
+
+        way = chunk.ways.nodes(result.way);
+        m_ways.openWay();
+
+        for(int i=0; i<chunk.ways.length(result.way); i++)
+            m_ways.pushNode(way[i]);
+
+        m_ways.closeWay();
+        result.way = m_ways.size() - 1;
+    }
+
+    m_explored += chunk.explored;
+}
+
+bool BatchAlgorithm::algorithm(int start, int finish, bool order)
+{
+    int tasks = qMax(1, QThread::idealThreadCount());
+    int count;
+    batch_result_t *results;
+
+    m_results.resize(m_queries.size());
+
+    for(int q=0; q<m_queries.size(); q++)
+    {
+        m_results[q].from = m_queries[q].from;
+        m_results[q].to = m_queries[q].to;
+        m_results[q].distance = -1;
+        m_results[q].way = -1;
+    }
+
+    group();
+    count = m_groups.size() - 1;
+
+    /* XXX: Chunks keep their buffers from round to round and run to run */
+    if (m_chunks.size() != tasks)
+    {
+        m_chunks.resize(tasks);
+
+        for(int c=0; c<tasks; c++)
+            m_chunks[c].distance = EpochArray(INF);
+    }
+
+    /* XXX: Tasks write distinct results, take the pointer once */
+    results = m_results.data();
+
+    for(int begin=0; begin<count; begin += Round)
+    {
+        int end = qMin(begin + (int) Round, count);
+        int step = (end - begin + tasks - 1) / tasks;
+
+        if (interrupted(end - begin))
+            return false;
+
+        for(int c=0; c<tasks; c++)
+        {
+            m_chunks[c].begin = qMin(begin + c * step, end);
+            m_chunks[c].end = qMin(m_chunks[c].begin + step, end);
+            m_chunks[c].explored = 0;
+            m_chunks[c].ways.clear();
+        }
+
+        QtConcurrent::blockingMap(m_chunks, [&](batch_chunk_t &chunk)
+        {
+            for(int g=chunk.begin; g<chunk.end; g++)
+                search(chunk, g, results);
+        });
+
+        for(int c=0; c<tasks; c++)
+            collect(m_chunks[c]);
+    }
+
+    return !m_results.isEmpty();
+}
+
+void BatchAlgorithm::apply(GraphicsView *view, int start)
+{
+    Raport *raport;
+    QVector<QString> lines;
+    int reached = 0;
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    /* XXX: One line per query, in the order they were given */
+    for(int q=0; q<m_results.size(); q++)
+    {
+        const batch_result_t &result = m_results[q];
+        QString line = QString("%1 - %2 : ").arg(result.from + 1)
+          .arg(result.to + 1);
+
+        if (result.distance < 0)
+        {
+            lines.push_back(line + "-");
+            continue;
+        }
+
+        line += QString::number(result.distance) + " :";
+
+        for(int i=0; i<m_ways.length(result.way); i++)
+            line += " " + QString::number(m_ways.nodes(result.way)[i] + 1);
+
+        lines.push_back(line);
+        reached++;
+    }
+
+    MainWindow::instance().createRaport();
+
+    if (!(raport = MainWindow::instance().getRaport()))
+        LOG_EXIT("Invalid pointer", );
+
+    raport->setRaport(QString("Batch: %1 queries, %2 starts, %3 reached")
+      .arg(m_results.size()).arg(m_groups.size() - 1).arg(reached));
+    raport->appendRaport(QString("Explored: %1").arg(m_explored));
+    raport->setTable(lines);
+    MainWindow::instance().showRaport();
+}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <QtConcurrent/QtConcurrentMap>
+
 #include "bfsalgorithm.h"
 
 BFSAlgorithm::BFSAlgorithm(QObject *parent)
-    : AbstractAlgorithm(parent)
+    : AbstractAlgorithm(parent),
+      m_position(-1),
+      m_side(0),
+      m_depth(0)
 {
 
 }
@@ -11,101 +17,340 @@ BFSAlgorithm::~BFSAlgorithm()
 
 }
 
-void BFSAlgorithm::algorithm(Node *start, Node *finish, GraphicsView *view,
-  bool order)
+bool BFSAlgorithm::algorithm(int start, int finish, bool order)
 {
-    int id;
-    bool debug, reset, found = false;
-    bool *visited = new bool[m_graph.size()]();
+    if (m_bidirectional)
+        return bidirectional(start, finish, order);
+
+    return unidirectional(start, finish, order);
+}
 
-    if (!visited)
+static inline bool testBit(const quint64 *bits, int i)
+{
+    return bits[i >> 6] & (Q_UINT64_C(1) << (i & 63));
+}
+
+static inline void setBit(quint64 *bits, int i)
+{
+    bits[i >> 6] |= Q_UINT64_C(1) << (i & 63);
+}
+
+static inline void clearBit(quint64 *bits, int i)
+{
+    bits[i >> 6] &= ~(Q_UINT64_C(1) << (i & 63));
+}
+
+static inline void claimMin(QAtomicInt &claim, int value)
+{
+    for(int current = claim.load(); value < current; current = claim.load())
     {
-        LOG_DEBUG("Invalid pointer");
+        if (claim.testAndSetOrdered(current, value))
+            break;
     }
+}
 
-    id = start->text().toInt() - 1;
-    visited[id] = reset = true;
-    m_list.push_back(id);
+void BFSAlgorithm::split(int begin, int end)
+{
+    int count = (end - begin + ChunkSize - 1) / ChunkSize;
 
-    /* XXX: For graph debugging */
-    debug = true;
+    /* XXX: Chunks keep their buffers from level to level and run to run */
+    m_chunks.resize(count);
 
-    while(!m_list.isEmpty())
+    for(int c=0; c<count; c++)
     {
-        Node *node;
-        int current = m_list.front();
+        m_chunks[c].begin = begin + c * ChunkSize;
+        m_chunks[c].end = qMin(m_chunks[c].begin + (int) ChunkSize, end);
+        m_chunks[c].found.clear();
+        m_chunks[c].keys.clear();
+    }
+}
 
-        m_list.pop_front();
-        m_way.push_back(new Vertex(current, false));
+void BFSAlgorithm::runChunks(QVector<bfs_chunk_t> &chunks,
+  std::function<void(bfs_chunk_t &)> fn) const
+{
+    /* XXX: Thread pool round trip costs more than a small level */
+    if (chunks.size() == 1)
+        fn(chunks[0]);
+    else if (chunks.size() > 1)
+        QtConcurrent::blockingMap(chunks, fn);
+}
 
-        if (!(node = view->findNodeByIndex(current)))
-        {
-            LOG_DEBUG("Node doesn't exist");
-            goto Exit;
-        }
+void BFSAlgorithm::topDown(int begin, int end, bool order)
+{
+    QVector<bfs_chunk_t> &chunks = m_chunks;
+    const quint64 *visited = m_visited.constData();
+    const int *queue = m_order.constData();
+    QAtomicInt *claim = m_claim.data();
 
-        if (debug)
-            m_debug.push_back(current + 1);
+    split(begin, end);
 
-        /* Mark opened nodes until not found connected one */
-        if (!found)
+    /* XXX: Each new node goes to the frontier node closest to the queue
+     * head, as the sequential walk would open it from there */
+    runChunks(chunks, [&](bfs_chunk_t &chunk)
+    {
+        for(int f=chunk.begin; f<chunk.end; f++)
         {
-            if (node != start)
-                node->setBrush(QBrush(Qt::yellow, Qt::SolidPattern));
+            const int *adj = m_graph.neighbors(queue[f]);
 
-            m_raport.push_back(current + 1);
+            for(int k=0; k<m_graph.degree(queue[f]); k++)
+            {
+                if (!testBit(visited, adj[k]))
+                    claimMin(claim[adj[k]], f);
+            }
         }
+    });
 
-        for(int i = order ? 0 : m_graph[current].size() - 1;
-            order ? (i<m_graph[current].size()) : (i>=0) ; order ? i++ : i--)
+    /* XXX: Walking winners in queue and row order gives the next level
+     * already sorted */
+    runChunks(chunks, [&](bfs_chunk_t &chunk)
+    {
+        for(int f=chunk.begin; f<chunk.end; f++)
         {
-            if (m_graph[current][i]) /* if connectced with i-node */
+            int current = queue[f];
+            const int *adj = m_graph.neighbors(current);
+            int degree = m_graph.degree(current);
+
+            for(int k = order ? 0 : degree - 1;
+                order ? (k<degree) : (k>=0) ; order ? k++ : k--)
             {
-                if (!(node = view->findNodeByIndex(i)))
+                int i = adj[k]; /* connected with i-node */
+
+                if (!testBit(visited, i) && claim[i].load() == f)
                 {
-                    LOG_DEBUG("Node doesn't exist");
-                    goto Exit;
+                    m_parent.set(i, current);
+                    chunk.found.push_back(i);
                 }
+            }
+        }
+    });
 
-            /* XXX: Workaround: Found only one way
-             * After found way, algorithm not stoping.
-             * We continue opening all nodes. This is important in case
-             * if want mark more than one way from start to finish point later. */
-                if ((node == finish) && !found)
-                {
-                    QVector<int> marked = markWay(view, finish, reset);
+    m_next.clear();
 
-                    if (marked.isEmpty())
-                        LOG_EXIT("Vector is empty", );
+    for(int c=0; c<chunks.size(); c++)
+        m_next += chunks[c].found;
+}
 
-                    /* XXX: Workaround */
-                    for(int i=0; i<marked.size(); i++)
-                        marked[i]++;
+void BFSAlgorithm::bottomUp(int begin, int end, bool order)
+{
+    QVector<bfs_chunk_t> &chunks = m_chunks;
+    QVector<QPair<qint64, int> > &sorted = m_sorted;
+    const quint64 *visited = m_visited.constData();
+    const quint64 *frontier = m_frontier.constData();
+    const int *queue = m_order.constData();
 
-                    found = true;
-                    reset = false;
+    split(0, m_graph.size());
+    sorted.clear();
 
-                    MainWindow::instance().createRaport();
-                    MainWindow::instance().getRaport()->setRaport(m_raport);
-                    MainWindow::instance().getRaport()->appendRaport(marked,
-		       "Way: ");
-                }
+    for(int f=begin; f<end; f++)
+        setBit(m_frontier.data(), m_order[f]);
+
+    /* XXX: Unvisited nodes look for a parent among arcs coming in. The
+     * whole row is scanned, the closest one to the queue head wins */
+    runChunks(chunks, [&](bfs_chunk_t &chunk)
+    {
+        for(int i=chunk.begin; i<chunk.end; i++)
+        {
+            int best = INF, degree, rank, from;
+            const int *adj, *row;
 
-                if (!visited[i]) /* if not visited yet */
+            if (testBit(visited, i))
+                continue;
+
+            adj = m_reverse.neighbors(i);
+
+            for(int k=0; k<m_reverse.degree(i); k++)
+            {
+                if (testBit(frontier, adj[k]) &&
+                     m_position.value(adj[k]) < best)
                 {
-                    visited[i] = true;
-                    m_list.push_back(i);
+                    best = m_position.value(adj[k]);
                 }
             }
+
+            if (best == INF)
+                continue;
+
+            from = queue[best];
+            m_parent.set(i, from);
+            row = m_graph.neighbors(from);
+            degree = m_graph.degree(from);
+            rank = std::lower_bound(row, row + degree, i) - row;
+
+            chunk.found.push_back(i);
+            chunk.keys.push_back(((qint64) best << 32) |
+              (order ? rank : degree - 1 - rank));
+        }
+    });
+
+    for(int f=begin; f<end; f++)
+        clearBit(m_frontier.data(), m_order[f]);
+
+    for(int c=0; c<chunks.size(); c++)
+    {
+        for(int j=0; j<chunks[c].found.size(); j++)
+            sorted.push_back(qMakePair(chunks[c].keys[j], chunks[c].found[j]));
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+
+    m_next.clear();
+
+    for(int j=0; j<sorted.size(); j++)
+        m_next.push_back(sorted[j].second);
+}
+
+bool BFSAlgorithm::unidirectional(int start, int finish, bool order)
+{
+    int size = m_graph.size(), words = (size + 63) / 64;
+    int begin = 0, end = 1, found = -1;
+    qint64 unexplored = m_graph.arcCount() - m_graph.degree(start);
+    bool bottom_up = false;
+
+    /* XXX: Bitmaps and claims are left clean by the previous run, only a
+     * new graph size costs a full fill */
+    if (m_visited.size() != words)
+    {
+        m_visited.fill(0, words);
+        m_frontier.fill(0, words);
+    }
+
+    if (m_claim.size() != size)
+        m_claim.fill(QAtomicInt(INF), size);
+
+    m_position.reset(size);
+    m_order.clear();
+    m_order.reserve(size);
+
+    m_order.push_back(start);
+    m_position.set(start, 0);
+    setBit(m_visited.data(), start);
+
+    /* XXX: Level by level. Small frontier pushes along its own arcs
+     * (top-down), a big one lets every unvisited node search for a parent
+     * in it (bottom-up) */
+    while(begin < end && found == -1 && !interrupted(end - begin))
+    {
+        qint64 frontier_arcs = 0;
+
+        for(int f=begin; f<end; f++)
+            frontier_arcs += m_graph.degree(m_order[f]);
+
+        if (!bottom_up && frontier_arcs > unexplored / Alpha)
+            bottom_up = true;
+        else if (bottom_up && (end - begin) < size / Beta)
+            bottom_up = false;
+
+        if (bottom_up)
+            reverseGraph();
+
+        if (bottom_up)
+            bottomUp(begin, end, order);
+        else
+            topDown(begin, end, order);
+
+        m_explored += end - begin;
+
+        for(int j=0; j<m_next.size(); j++)
+        {
+            int i = m_next[j];
+
+            setBit(m_visited.data(), i);
+            m_claim[i].store(INF);
+            m_position.set(i, m_order.size());
+            m_order.push_back(i);
+            unexplored -= m_graph.degree(i);
+
+            if (i == finish)
+                found = m_position.value(m_parent.value(i));
         }
+
+        begin = end;
+        end = m_order.size();
     }
 
-    if (!found)
-        MainWindow::instance().showMessage("Solution not found!");
+    for(int j=0; j<m_order.size(); j++)
+        clearBit(m_visited.data(), m_order[j]);
+
+    if (found == -1)
+        return false;
+
+    /* Remember opened nodes until not found connected one */
+    m_raport = m_order.mid(0, found + 1);
+    return addWay(start, finish);
+}
+
+bool BFSAlgorithm::bidirectional(int start, int finish, bool order)
+{
+    QVector<int> &forward = m_forward, &backward = m_backward;
+    int best = INF, meet_from = -1, meet_to = -1;
+
+    m_side.reset(m_graph.size());
+    m_depth.reset(m_graph.size());
+    forward.clear();
+    backward.clear();
+
+    m_side.set(start, Forward);
+    m_side.set(finish, Backward);
+    forward.push_back(start);
+    backward.push_back(finish);
+
+    /* XXX: Grow the smaller frontier by a whole level. The first level
+     * which touches the other side holds the shortest way, take the best
+     * meeting arc of that level */
+    while(!forward.isEmpty() && !backward.isEmpty() && best == INF &&
+          !interrupted())
+    {
+        bool is_forward = forward.size() <= backward.size();
+        QVector<int> &frontier = is_forward ? forward : backward;
+        const CSRGraph &graph = is_forward ? m_graph : m_reverse;
+        EpochArray &parent = is_forward ? m_parent : m_reverse_parent;
+        char own = is_forward ? Forward : Backward;
+
+        m_next.clear();
+
+        for(int f=0; f<frontier.size() && !interrupted(); f++)
+        {
+            int current = frontier[f];
+            const int *adj = graph.neighbors(current);
+            int degree = graph.degree(current);
+
+            m_explored++;
+            m_raport.push_back(current);
+
+            for(int k = order ? 0 : degree - 1;
+                order ? (k<degree) : (k>=0) ; order ? k++ : k--)
+            {
+                int i = adj[k]; /* connected with i-node */
+
+                if (m_side.value(i) == own)
+                    continue;
+
+                if (m_side.value(i)) /* reached by the other side */
+                {
+                    int length = m_depth.value(current) + 1 + m_depth.value(i);
+
+                    if (length < best)
+                    {
+                        best = length;
+                        meet_from = is_forward ? current : i;
+                        meet_to = is_forward ? i : current;
+                    }
+
+                    continue;
+                }
+
+                m_side.set(i, own);
+                m_depth.set(i, m_depth.value(current) + 1);
+                parent.set(i, current);
+                m_next.push_back(i);
+            }
+        }
+
+        frontier.swap(m_next);
+    }
 
-    if (debug)
-        qDebug() << m_debug;
+    if (best == INF)
+        return false;
 
-  Exit:
-    delete[] visited;
+    return addMeetWay(start, meet_from, meet_to, finish);
 }
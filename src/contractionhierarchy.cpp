@@ -0,0 +1,621 @@
+#include <algorithm>
+#include <cstring>
+
+#include "contractionhierarchy.h"
+#include "log.h"
+
+#ifndef INF
+#define INF INT32_MAX
+#endif
+
+ContractionHierarchy::ContractionHierarchy()
+    : m_fingerprint(0),
+      m_shortcuts(0),
+      m_explored(0),
+      m_witness(INF),
+      m_target(0)
+{
+    for(int i=0; i<2; i++)
+    {
+        m_distance[i] = EpochArray(INF);
+        m_parent[i] = EpochArray(-1);
+    }
+}
+
+ContractionHierarchy::~ContractionHierarchy()
+{
+
+}
+
+void ContractionHierarchy::clear()
+{
+    m_up.clear();
+    m_down.clear();
+    m_rank.clear();
+    m_middle.clear();
+    m_fingerprint = 0;
+    m_shortcuts = 0;
+    m_explored = 0;
+    m_out.clear();
+    m_in.clear();
+    m_contracted.clear();
+    m_priority.clear();
+    m_pending.clear();
+}
+
+bool ContractionHierarchy::isEmpty() const
+{
+    return m_rank.isEmpty();
+}
+
+int ContractionHierarchy::size() const
+{
+    return m_rank.size();
+}
+
+int ContractionHierarchy::shortcuts() const
+{
+    return m_shortcuts;
+}
+
+int ContractionHierarchy::explored() const
+{
+    return m_explored;
+}
+
+void ContractionHierarchy::witness(int source, int skip, int limit,
+  int targets)
+{
+    BinaryHeap &heap = m_heap[0];
+    int settled = 0;
+
+    /* XXX: The source is no target of its own */
+    if (m_target.contains(source))
+        targets--;
+
+    m_witness.reset(m_out.size());
+    heap.clear();
+
+    m_witness.set(source, 0);
+    heap.push(0, source);
+
+    /* XXX: Limited search, a missed witness costs a needless shortcut
+     * only, never a wrong distance */
+    while(!heap.isEmpty())
+    {
+        int key, current;
+        const int *adj, *weights;
+
+        heap.pop(&key, &current);
+
+        if (key > m_witness.value(current))
+            continue;
+
+        if (key > limit || ++settled > WitnessLimit)
+            break;
+
+        /* XXX: Every head of a shortcut has its final distance */
+        if (current != source && m_target.contains(current) && !--targets)
+            break;
+
+        adj = m_out.neighbors(current);
+        weights = m_out.weights(current);
+
+        for(int k=0; k<m_out.degree(current); k++)
+        {
+            int i = adj[k];
+
+            if (i == skip || m_rank[i] != -1)
+                continue;
+
+            if (key + weights[k] < m_witness.value(i))
+            {
+                m_witness.set(i, key + weights[k]);
+                heap.push(key + weights[k], i);
+            }
+        }
+    }
+}
+
+int ContractionHierarchy::simulate(int node)
+{
+    const int *in_adj = m_in.neighbors(node), *in_weights = m_in.weights(node);
+    const int *out_adj = m_out.neighbors(node);
+    const int *out_weights = m_out.weights(node);
+    int longest = 0, targets = 0;
+
+    m_pending.clear();
+    m_target.reset(m_out.size());
+
+    for(int k=0; k<m_out.degree(node); k++)
+    {
+        if (m_rank[out_adj[k]] == -1 && out_adj[k] != node)
+        {
+            longest = qMax(longest, out_weights[k]);
+            m_target.set(out_adj[k], 1);
+            targets++;
+        }
+    }
+
+    for(int j=0; j<m_in.degree(node); j++)
+    {
+        int from = in_adj[j];
+
+        if (m_rank[from] != -1 || from == node)
+            continue;
+
+        witness(from, node, in_weights[j] + longest, targets);
+
+        for(int k=0; k<m_out.degree(node); k++)
+        {
+            hierarchy_arc_t arc;
+
+            arc.from = from;
+            arc.to = out_adj[k];
+            arc.weight = in_weights[j] + out_weights[k];
+            arc.middle = node;
+
+            if (m_rank[arc.to] != -1 || arc.to == from || arc.to == node)
+                continue;
+
+            if (m_witness.value(arc.to) <= arc.weight)
+                continue;
+
+            m_pending.push_back(arc);
+        }
+    }
+
+    return m_pending.size();
+}
+
+int ContractionHierarchy::priority(int node)
+{
+    int degree = 0;
+
+    for(int k=0; k<m_out.degree(node); k++)
+        degree += m_rank[m_out.neighbors(node)[k]] == -1;
+
+    for(int k=0; k<m_in.degree(node); k++)
+        degree += m_rank[m_in.neighbors(node)[k]] == -1;
+
+    /* XXX: Edge difference, contracted neighbours spread the order */
+    return simulate(node) - degree + m_contracted[node];
+}
+
+void ContractionHierarchy::addShortcut(int from, int to, int weight,
+  int middle)
+{
+    if (m_out.contains(from, to))
+    {
+        if (m_out.weight(from, to) <= weight)
+            return;
+
+        m_out.setWeight(from, to, weight);
+        m_in.setWeight(to, from, weight);
+    }
+    else
+    {
+        m_out.insertArc(from, to, weight);
+        m_in.insertArc(to, from, weight);
+    }
+
+    m_middle.insert(arcKey(from, to), middle);
+}
+
+void ContractionHierarchy::detach(int node, QVector<hierarchy_arc_t> *arcs)
+{
+    /* XXX: Arcs of a contracted node are final, they leave the remaining
+     * graph, so its degrees stay small up to the top ranks. The node's
+     * own rows are kept, nothing leads to them any more */
+    for(int side=0; side<2; side++)
+    {
+        CSRGraph &graph = side ? m_in : m_out, &other = side ? m_out : m_in;
+
+        for(int k=0; k<graph.degree(node); k++)
+        {
+            hierarchy_arc_t arc;
+            int i = graph.neighbors(node)[k];
+
+            if (i == node)
+                continue;
+
+            arc.from = side ? i : node;
+            arc.to = side ? node : i;
+            arc.weight = graph.weights(node)[k];
+            arc.middle = -1;
+            arcs->push_back(arc);
+            other.removeArc(i, node);
+        }
+    }
+}
+
+void ContractionHierarchy::split(const QVector<hierarchy_arc_t> &arcs)
+{
+    QVector<arc_t> up, down;
+
+    for(int i=0; i<arcs.size(); i++)
+    {
+        arc_t arc;
+
+        arc.weight = arcs[i].weight;
+
+        if (m_rank[arcs[i].from] < m_rank[arcs[i].to])
+        {
+            arc.from = arcs[i].from;
+            arc.to = arcs[i].to;
+            up.push_back(arc);
+        }
+        else
+        {
+            arc.from = arcs[i].to;
+            arc.to = arcs[i].from;
+            down.push_back(arc);
+        }
+    }
+
+    m_up.build(m_rank.size(), up);
+    m_down.build(m_rank.size(), down);
+}
+
+bool ContractionHierarchy::build(const CSRGraph &graph,
+  std::function<bool(int)> stop)
+{
+    BinaryHeap order;
+    QVector<hierarchy_arc_t> arcs;
+    int size = graph.size(), rank = 0;
+
+    clear();
+
+    if (!size)
+        LOG_EXIT("Graph is empty", false);
+
+    m_out = graph;
+    m_in = graph.reversed();
+    m_rank.fill(-1, size);
+    m_contracted.fill(0, size);
+    m_fingerprint = graph.fingerprint();
+
+    order.reserve(size);
+    m_priority.resize(size);
+
+    for(int i=0; i<size; i++)
+    {
+        m_priority[i] = priority(i);
+        order.push(m_priority[i], i);
+    }
+
+    while(!order.isEmpty())
+    {
+        int key, node, current;
+
+        order.pop(&key, &node);
+
+        /* Stale entry, the node was queued again since */
+        if (m_rank[node] != -1 || key != m_priority[node])
+            continue;
+
+        /* XXX: Lazy update, a node got dearer since it was queued.
+         * Otherwise its shortcuts are left in m_pending by priority() */
+        if ((current = priority(node)) > key)
+        {
+            m_priority[node] = current;
+            order.push(current, node);
+            continue;
+        }
+
+        if (stop && stop(1))
+        {
+            clear();
+            return false;
+        }
+
+        /* XXX: Rows of node may move on insert, so shortcuts go in after
+         * the walk over them */
+        for(int i=0; i<m_pending.size(); i++)
+        {
+            addShortcut(m_pending[i].from, m_pending[i].to,
+              m_pending[i].weight, m_pending[i].middle);
+        }
+
+        m_rank[node] = rank++;
+        detach(node, &arcs);
+
+        /* XXX: Neighbours get their new priority lazily, when popped */
+        for(int side=0; side<2; side++)
+        {
+            const CSRGraph &graph = side ? m_in : m_out;
+
+            for(int k=0; k<graph.degree(node); k++)
+                m_contracted[graph.neighbors(node)[k]]++;
+        }
+    }
+
+    split(arcs);
+
+    m_shortcuts = m_middle.size();
+    m_out.clear();
+    m_in.clear();
+    m_contracted.clear();
+    m_priority.clear();
+
+    return true;
+}
+
+void ContractionHierarchy::unpack(int from, int to, QVector<int> *way)
+{
+    m_stack.clear();
+    m_stack.push_back(from);
+    m_stack.push_back(to);
+
+    /* XXX: Pairs on the stack, a shortcut splits into two, first half
+     * on top so nodes come out in order */
+    while(!m_stack.isEmpty())
+    {
+        int last = m_stack.back(), first, middle;
+
+        m_stack.pop_back();
+        first = m_stack.back();
+        m_stack.pop_back();
+
+        middle = m_middle.value(arcKey(first, last), -1);
+
+        if (middle == -1)
+        {
+            way->push_back(last);
+            continue;
+        }
+
+        m_stack.push_back(middle);
+        m_stack.push_back(last);
+        m_stack.push_back(first);
+        m_stack.push_back(middle);
+    }
+}
+
+int ContractionHierarchy::query(int start, int finish, QVector<int> *way)
+{
+    const CSRGraph *graphs[2] = { &m_up, &m_down };
+    int best = INF, meet = -1, side = 0;
+    QVector<int> chain;
+
+    m_explored = 0;
+
+    if (!way)
+        LOG_EXIT("Invalid pointer", INF);
+
+    way->clear();
+
+    if (start < 0 || start >= size() || finish < 0 || finish >= size())
+        LOG_EXIT("Invalid parameter:" << start << finish, INF);
+
+    for(int i=0; i<2; i++)
+    {
+        m_distance[i].reset(size());
+        m_parent[i].reset(size());
+        m_heap[i].clear();
+    }
+
+    m_distance[0].set(start, 0);
+    m_distance[1].set(finish, 0);
+    m_heap[0].push(0, start);
+    m_heap[1].push(0, finish);
+
+    /* XXX: Sides take turns, a side whose queue reached the best way
+     * found so far has nothing shorter to offer and is dropped */
+    while(!m_heap[0].isEmpty() || !m_heap[1].isEmpty())
+    {
+        EpochArray &own = m_distance[side], &other = m_distance[1 - side];
+        const CSRGraph &graph = *graphs[side];
+        int key, current;
+        const int *adj, *weights;
+
+        if (m_heap[side].isEmpty())
+        {
+            side = 1 - side;
+            continue;
+        }
+
+        m_heap[side].pop(&key, &current);
+
+        if (key > own.value(current))
+            continue;
+
+        if (key >= best)
+        {
+            m_heap[side].clear();
+            continue;
+        }
+
+        m_explored++;
+
+        if (other.value(current) != INF && key + other.value(current) < best)
+        {
+            best = key + other.value(current);
+            meet = current;
+        }
+
+        adj = graph.neighbors(current);
+        weights = graph.weights(current);
+
+        for(int k=0; k<graph.degree(current); k++)
+        {
+            if (key + weights[k] < own.value(adj[k]))
+            {
+                own.set(adj[k], key + weights[k]);
+                m_parent[side].set(adj[k], current);
+                m_heap[side].push(key + weights[k], adj[k]);
+            }
+        }
+
+        side = 1 - side;
+    }
+
+    if (meet == -1)
+        return INF;
+
+    /* XXX: Up from start to meet, then down from meet to finish */
+    for(int node = meet; node != -1; node = m_parent[0].value(node))
+        chain.push_back(node);
+
+    std::reverse(chain.begin(), chain.end());
+
+    for(int node = m_parent[1].value(meet); node != -1;
+         node = m_parent[1].value(node))
+    {
+        chain.push_back(node);
+    }
+
+    way->push_back(start);
+
+    for(int i=0; i + 1<chain.size(); i++)
+        unpack(chain[i], chain[i + 1], way);
+
+    return best;
+}
+
+bool ContractionHierarchy::save(QIODevice *device) const
+{
+    hierarchy_header_t header;
+    QVector<hierarchy_arc_t> arcs;
+    QVector<qint32> ranks;
+
+    if (isEmpty())
+        LOG_EXIT("Hierarchy is empty", false);
+
+    /* XXX: Arcs go in graph direction, load() splits them by rank again */
+    for(int i=0; i<size(); i++)
+    {
+        for(int k=0; k<m_up.degree(i); k++)
+        {
+            hierarchy_arc_t arc;
+
+            arc.from = i;
+            arc.to = m_up.neighbors(i)[k];
+            arc.weight = m_up.weights(i)[k];
+            arc.middle = m_middle.value(arcKey(arc.from, arc.to), -1);
+            arcs.push_back(arc);
+        }
+
+        for(int k=0; k<m_down.degree(i); k++)
+        {
+            hierarchy_arc_t arc;
+
+            arc.from = m_down.neighbors(i)[k];
+            arc.to = i;
+            arc.weight = m_down.weights(i)[k];
+            arc.middle = m_middle.value(arcKey(arc.from, arc.to), -1);
+            arcs.push_back(arc);
+        }
+    }
+
+    for(int i=0; i<size(); i++)
+        ranks.push_back(m_rank[i]);
+
+    memcpy(header.magic, HIERARCHY_MAGIC, sizeof(header.magic));
+    header.version = HIERARCHY_VERSION;
+    header.size = size();
+    header.arcs = arcs.size();
+    header.fingerprint = m_fingerprint;
+
+    if (device->write((const char*) &header, sizeof(header)) !=
+           sizeof(header) ||
+         device->write((const char*) ranks.constData(),
+           ranks.size() * sizeof(qint32)) !=
+           (qint64) (ranks.size() * sizeof(qint32)) ||
+         device->write((const char*) arcs.constData(),
+           arcs.size() * sizeof(hierarchy_arc_t)) !=
+           (qint64) (arcs.size() * sizeof(hierarchy_arc_t)))
+    {
+        LOG_EXIT("Can't write hierarchy", false);
+    }
+
+    return true;
+}
+
+bool ContractionHierarchy::load(QIODevice *device, const CSRGraph &graph)
+{
+    hierarchy_header_t header;
+    QVector<hierarchy_arc_t> arcs;
+    QVector<qint32> ranks;
+    QVector<bool> seen;
+
+    clear();
+
+    if (device->read((char*) &header, sizeof(header)) != sizeof(header) ||
+         memcmp(header.magic, HIERARCHY_MAGIC, sizeof(header.magic)) ||
+         header.version != HIERARCHY_VERSION || header.arcs < 0)
+    {
+        LOG_EXIT("Invalid hierarchy data", false);
+    }
+
+    if (header.size != graph.size() ||
+         header.fingerprint != graph.fingerprint())
+        LOG_EXIT("Hierarchy of another graph", false);
+
+    /* XXX: Counts come from the data, nothing is allocated for more than
+     * the device holds */
+    if (device->bytesAvailable() < header.size * (qint64) sizeof(qint32) +
+         header.arcs * (qint64) sizeof(hierarchy_arc_t))
+    {
+        LOG_EXIT("Truncated hierarchy data", false);
+    }
+
+    ranks.resize(header.size);
+    arcs.resize(header.arcs);
+
+    if (device->read((char*) ranks.data(), ranks.size() * sizeof(qint32)) !=
+           (qint64) (ranks.size() * sizeof(qint32)) ||
+         device->read((char*) arcs.data(),
+           arcs.size() * sizeof(hierarchy_arc_t)) !=
+           (qint64) (arcs.size() * sizeof(hierarchy_arc_t)))
+    {
+        LOG_EXIT("Truncated hierarchy data", false);
+    }
+
+    /* XXX: Ranks are a permutation of 0..size-1 */
+    seen.fill(false, header.size);
+
+    for(int i=0; i<ranks.size(); i++)
+    {
+        if (ranks[i] < 0 || ranks[i] >= header.size || seen[ranks[i]])
+            LOG_EXIT("Invalid rank in hierarchy data", false);
+
+        seen[ranks[i]] = true;
+    }
+
+    for(int i=0; i<arcs.size(); i++)
+    {
+        const hierarchy_arc_t &arc = arcs[i];
+
+        if (arc.from < 0 || arc.from >= header.size || arc.to < 0 ||
+             arc.to >= header.size || arc.middle >= header.size)
+        {
+            LOG_EXIT("Invalid arc in hierarchy data", false);
+        }
+
+        /* XXX: A middle node ranks below both ends, so unpack() goes down
+         * with every split and can't loop */
+        if (arc.middle >= 0 && (ranks[arc.middle] >= ranks[arc.from] ||
+             ranks[arc.middle] >= ranks[arc.to]))
+        {
+            LOG_EXIT("Invalid shortcut in hierarchy data", false);
+        }
+    }
+
+    for(int i=0; i<arcs.size(); i++)
+    {
+        if (arcs[i].middle >= 0)
+        {
+            m_middle.insert(arcKey(arcs[i].from, arcs[i].to), arcs[i].middle);
+            m_shortcuts++;
+        }
+    }
+
+    for(int i=0; i<ranks.size(); i++)
+        m_rank.push_back(ranks[i]);
+
+    split(arcs);
+    m_fingerprint = header.fingerprint;
+
+    return true;
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cstring>
+
+#include "csrgraph.h"
+#include "log.h"
+
+static bool arcLess(const arc_t &a, const arc_t &b)
+{
+    return (a.from != b.from) ? (a.from < b.from) : (a.to < b.to);
+}
+
+CSRGraph::CSRGraph()
+    : m_starts(0),
+      m_degrees(0),
+      m_capacities(0),
+      m_neighbors(0),
+      m_weights(0),
+      m_arcs(0),
+      m_holes(0)
+{
+
+}
+
+CSRGraph::~CSRGraph()
+{
+
+}
+
+void CSRGraph::build(int size, QVector<arc_t> arcs)
+{
+    clear();
+
+    if (size <= 0)
+        LOG_EXIT("Invalid size", );
+
+    for(int i=0; i<arcs.size(); i++)
+    {
+        const arc_t &arc = arcs[i];
+
+        if (arc.from < 0 || arc.from >= size || arc.to < 0 || arc.to >= size)
+            LOG_EXIT("Invalid arc:" << arc.from << arc.to, );
+    }
+
+    /* XXX: stable, so the last duplicate arc wins, the same as the old
+     * matrix assignment did */
+    std::stable_sort(arcs.begin(), arcs.end(), arcLess);
+
+    m_starts.fill(0, size);
+    m_degrees.fill(0, size);
+    m_neighbors.reserve(arcs.size());
+    m_weights.reserve(arcs.size());
+
+    for(int i=0; i<arcs.size(); i++)
+    {
+        const arc_t &arc = arcs[i];
+
+        if (i && arcs[i - 1].from == arc.from && arcs[i - 1].to == arc.to)
+        {
+            m_weights.back() = arc.weight;
+            continue;
+        }
+
+        m_neighbors.push_back(arc.to);
+        m_weights.push_back(arc.weight);
+        m_degrees[arc.from]++;
+    }
+
+    for(int i=1; i<size; i++)
+        m_starts[i] = m_starts[i - 1] + m_degrees[i - 1];
+
+    /* XXX: Built rows are tight, the first insert moves a row to the tail */
+    m_capacities = m_degrees;
+    m_arcs = m_neighbors.size();
+}
+
+void CSRGraph::assign(int size, const qint32 *offsets,
+  const qint32 *neighbors, const qint32 *weights)
+{
+    int arcs;
+
+    clear();
+
+    if (size <= 0 || !offsets || offsets[0] != 0)
+        LOG_EXIT("Invalid rows", );
+
+    arcs = offsets[size];
+    m_starts.resize(size);
+    m_degrees.resize(size);
+    m_neighbors.resize(arcs);
+    m_weights.resize(arcs);
+
+    for(int i=0; i<size; i++)
+    {
+        m_starts[i] = offsets[i];
+        m_degrees[i] = offsets[i + 1] - offsets[i];
+    }
+
+    if (arcs)
+    {
+        memcpy(m_neighbors.data(), neighbors, arcs * sizeof(qint32));
+        memcpy(m_weights.data(), weights, arcs * sizeof(qint32));
+    }
+
+    m_capacities = m_degrees;
+    m_arcs = arcs;
+}
+
+void CSRGraph::clear()
+{
+    m_starts.clear();
+    m_degrees.clear();
+    m_capacities.clear();
+    m_neighbors.clear();
+    m_weights.clear();
+    m_arcs = 0;
+    m_holes = 0;
+}
+
+void CSRGraph::resize(int size)
+{
+    if (size < 0)
+        LOG_EXIT("Invalid size:" << size, );
+
+    for(int i=size; i<m_starts.size(); i++)
+    {
+        m_arcs -= m_degrees[i];
+        m_holes += m_capacities[i];
+    }
+
+    /* XXX: New rows are empty and own no slots yet */
+    m_starts.resize(size);
+    m_degrees.resize(size);
+    m_capacities.resize(size);
+
+    if (!size)
+        clear();
+}
+
+int CSRGraph::find(int from, int to) const
+{
+    const int *begin, *end, *found;
+
+    if (from < 0 || from >= size())
+        return -1;
+
+    begin = neighbors(from);
+    end = begin + degree(from);
+    found = std::lower_bound(begin, end, to);
+
+    if (found == end || *found != to)
+        return -1;
+
+    return found - begin;
+}
+
+void CSRGraph::grow(int node)
+{
+    int start = m_starts[node], capacity = m_capacities[node];
+    int tail = m_neighbors.size();
+    int wanted = qMax(4, capacity * 2);
+
+    /* XXX: Row at the tail just grows, any other one moves there */
+    if (capacity && start + capacity == tail)
+    {
+        m_neighbors.resize(start + wanted);
+        m_weights.resize(start + wanted);
+    }
+    else
+    {
+        m_neighbors.resize(tail + wanted);
+        m_weights.resize(tail + wanted);
+
+        std::copy(m_neighbors.constData() + start,
+          m_neighbors.constData() + start + m_degrees[node],
+          m_neighbors.data() + tail);
+        std::copy(m_weights.constData() + start,
+          m_weights.constData() + start + m_degrees[node],
+          m_weights.data() + tail);
+
+        m_starts[node] = tail;
+        m_holes += capacity;
+    }
+
+    m_capacities[node] = wanted;
+}
+
+void CSRGraph::compact()
+{
+    QVector<int> neighbors, weights;
+
+    neighbors.reserve(m_arcs);
+    weights.reserve(m_arcs);
+
+    for(int i=0; i<size(); i++)
+    {
+        int start = neighbors.size();
+
+        for(int k=0; k<m_degrees[i]; k++)
+        {
+            neighbors.push_back(m_neighbors[m_starts[i] + k]);
+            weights.push_back(m_weights[m_starts[i] + k]);
+        }
+
+        m_starts[i] = start;
+        m_capacities[i] = m_degrees[i];
+    }
+
+    m_neighbors = neighbors;
+    m_weights = weights;
+    m_holes = 0;
+}
+
+bool CSRGraph::insertArc(int from, int to, int weight)
+{
+    int *adj, *w, pos;
+
+    if (from < 0 || from >= size() || to < 0 || to >= size())
+        LOG_EXIT("Invalid arc:" << from << to, false);
+
+    if (find(from, to) != -1)
+        return false;
+
+    if (m_degrees[from] == m_capacities[from])
+        grow(from);
+
+    adj = m_neighbors.data() + m_starts[from];
+    w = m_weights.data() + m_starts[from];
+    pos = std::lower_bound(adj, adj + m_degrees[from], to) - adj;
+
+    /* XXX: Keep the row sorted, shift its tail by one */
+    std::copy_backward(adj + pos, adj + m_degrees[from],
+      adj + m_degrees[from] + 1);
+    std::copy_backward(w + pos, w + m_degrees[from], w + m_degrees[from] + 1);
+
+    adj[pos] = to;
+    w[pos] = weight;
+    m_degrees[from]++;
+    m_arcs++;
+
+    if (m_holes > m_arcs + size())
+        compact();
+
+    return true;
+}
+
+bool CSRGraph::removeArc(int from, int to)
+{
+    int *adj, *w, pos;
+
+    if ((pos = find(from, to)) == -1)
+        return false;
+
+    adj = m_neighbors.data() + m_starts[from];
+    w = m_weights.data() + m_starts[from];
+
+    std::copy(adj + pos + 1, adj + m_degrees[from], adj + pos);
+    std::copy(w + pos + 1, w + m_degrees[from], w + pos);
+
+    m_degrees[from]--;
+    m_arcs--;
+
+    return true;
+}
+
+bool CSRGraph::setWeight(int from, int to, int weight)
+{
+    int pos;
+
+    if ((pos = find(from, to)) == -1)
+        return false;
+
+    m_weights[m_starts[from] + pos] = weight;
+
+    return true;
+}
+
+bool CSRGraph::contains(int from, int to) const
+{
+    return find(from, to) != -1;
+}
+
+bool CSRGraph::isEmpty() const
+{
+    return !size();
+}
+
+int CSRGraph::size() const
+{
+    return m_starts.size();
+}
+
+int CSRGraph::arcCount() const
+{
+    return m_arcs;
+}
+
+int CSRGraph::degree(int node) const
+{
+    return m_degrees[node];
+}
+
+const int *CSRGraph::neighbors(int node) const
+{
+    return m_neighbors.constData() + m_starts[node];
+}
+
+const int *CSRGraph::weights(int node) const
+{
+    return m_weights.constData() + m_starts[node];
+}
+
+int CSRGraph::weight(int from, int to) const
+{
+    int pos = find(from, to);
+
+    return pos == -1 ? 0 : weights(from)[pos];
+}
+
+CSRGraph CSRGraph::reversed() const
+{
+    CSRGraph result;
+    QVector<int> fill;
+
+    result.m_starts.fill(0, size());
+    result.m_degrees.fill(0, size());
+    result.m_neighbors.resize(arcCount());
+    result.m_weights.resize(arcCount());
+    result.m_arcs = arcCount();
+
+    for(int i=0; i<size(); i++)
+    {
+        for(int k=0; k<degree(i); k++)
+            result.m_degrees[neighbors(i)[k]]++;
+    }
+
+    for(int i=1; i<size(); i++)
+        result.m_starts[i] = result.m_starts[i - 1] + result.m_degrees[i - 1];
+
+    result.m_capacities = result.m_degrees;
+
+    /* XXX: Rows are scanned in increasing order, so every reversed row
+     * comes out sorted without an extra pass */
+    fill = result.m_starts;
+
+    for(int i=0; i<size(); i++)
+    {
+        for(int k=0; k<degree(i); k++)
+        {
+            int pos = fill[neighbors(i)[k]]++;
+
+            result.m_neighbors[pos] = i;
+            result.m_weights[pos] = weights(i)[k];
+        }
+    }
+
+    return result;
+}
+
+quint64 CSRGraph::fingerprint() const
+{
+    /* XXX: FNV-1a over every arc, rows are sorted so it's canonical */
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    const quint64 prime = Q_UINT64_C(1099511628211);
+
+    hash = (hash ^ (quint32) size()) * prime;
+
+    for(int i=0; i<size(); i++)
+    {
+        const int *adj = neighbors(i);
+        const int *w = weights(i);
+
+        for(int k=0; k<degree(i); k++)
+        {
+            hash = (hash ^ (quint32) i) * prime;
+            hash = (hash ^ (quint32) adj[k]) * prime;
+            hash = (hash ^ (quint32) w[k]) * prime;
+        }
+    }
+
+    return hash;
+}
+
+QVector<QVector<int> > CSRGraph::toMatrix() const
+{
+    QVector<QVector<int> > matrix(size(), QVector<int>(size(), 0));
+
+    for(int i=0; i<size(); i++)
+    {
+        const int *adj = neighbors(i);
+        const int *w = weights(i);
+
+        for(int j=0; j<degree(i); j++)
+            matrix[i][adj[j]] = w[j];
+    }
+
+    return matrix;
+}
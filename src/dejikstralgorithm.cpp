@@ -1,7 +1,44 @@
+#include <QDir>
+
 #include "dejikstralgorithm.h"
+#include "allpairs.h"
+
+static QString nodeName(Node *node)
+{
+    return node->label().isEmpty() ? node->text() : node->label();
+}
+
+static void setDistance(Node *node, QString path)
+{
+    if (node->label().isEmpty())
+        node->setToolTip(path);
+    else
+        node->setToolTip(node->label() + ", " + path);
+}
 
 DejikstraAlgorithm::DejikstraAlgorithm(QObject *parent)
-    : AbstractAlgorithm(parent)
+    : AbstractAlgorithm(parent),
+      m_heap(BinaryHeapID),
+      m_settled(0),
+      m_reverse_shortest(INF),
+      m_pred_head(-1),
+      m_pred_node(0),
+      m_pred_next(0),
+      m_tree_version(NoVersion),
+      m_changes(0),
+      m_changes_version(NoVersion),
+      m_changes_valid(false),
+      m_dynamic(false),
+      m_use_tree(false),
+      m_repaired(false),
+      m_repaired_from(NoVersion),
+      m_shown_version(NoVersion),
+      m_hierarchy_version(NoVersion),
+      m_hierarchy_enabled(false),
+      m_hierarchy_built(false),
+      m_all_pairs(false),
+      m_matrix_ready(false),
+      m_matrix_method(0)
 {
 
 }
@@ -11,275 +48,769 @@ DejikstraAlgorithm::~DejikstraAlgorithm()
 
 }
 
-void DejikstraAlgorithm::algorithm(Node *start, Node *finish, GraphicsView *view,
-  bool order)
+void DejikstraAlgorithm::setHeap(HeapID heap)
+{
+    m_heap = heap;
+}
+
+void DejikstraAlgorithm::configure(Tab *tab)
+{
+    QComboBox *heaps;
+    QCheckBox *all, *dynamic, *hierarchy;
+
+    AbstractAlgorithm::configure(tab);
+
+    if (tab && (heaps = tab->getHeapCB()))
+        m_heap = (HeapID) heaps->currentIndex();
+
+    if (tab && (all = tab->getAllPairsCB()))
+        m_all_pairs = all->isChecked();
+
+    if (tab && (dynamic = tab->getDynamicCB()))
+        m_dynamic = dynamic->isChecked();
+
+    if (tab && (hierarchy = tab->getHierarchyCB()))
+        m_hierarchy_enabled = hierarchy->isChecked();
+}
+
+void DejikstraAlgorithm::initGraph()
+{
+    GraphicsView *view = MainWindow::instance().getView();
+
+    AbstractAlgorithm::initGraph();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    /* XXX: Taken here, the model is not to be read by the worker */
+    m_changes_version = graphVersion();
+    m_changes_valid = m_tree_version != NoVersion &&
+      view->getModel().changesSince(m_tree_version, &m_changes);
+}
+
+bool DejikstraAlgorithm::cacheable() const
+{
+    /* XXX: Matrix file is rewritten by every all pairs run */
+    return !m_all_pairs;
+}
+
+QString DejikstraAlgorithm::variant() const
+{
+    return AbstractAlgorithm::variant() + QString(" heap=%1 tree=%2 ch=%3")
+      .arg(m_heap).arg(m_dynamic).arg(m_hierarchy_enabled);
+}
+
+void DejikstraAlgorithm::saveResult(algorithm_result_t *result) const
+{
+    AbstractAlgorithm::saveResult(result);
+
+    result->distances.fill(-1, m_graph.size());
+
+    for(int i=0; i<m_graph.size(); i++)
+    {
+        if (m_use_tree && m_tree.distance(i) != INF)
+            result->distances[i] = m_tree.distance(i);
+        else if (!m_use_tree && (m_settled.value(i) & Forward))
+            result->distances[i] = m_shortest.value(i);
+    }
+}
+
+void DejikstraAlgorithm::loadResult(const algorithm_result_t &result)
 {
-    int id;
-    bool debug, found = false;
-    bool *visited = new bool[m_graph.size()]();
+    AbstractAlgorithm::loadResult(result);
 
-    m_shortest = new int[m_graph.size()];
+    m_settled.reset(result.distances.size());
+    m_shortest.reset(result.distances.size());
 
-    if (!visited || !m_shortest)
+    for(int i=0; i<result.distances.size(); i++)
     {
-        LOG_DEBUG("Invalid pointer");
+        if (result.distances[i] < 0)
+            continue;
+
+        m_settled.set(i, Forward);
+        m_shortest.set(i, result.distances[i]);
     }
 
-    /* XXX: Init array of ways with INf value */
-    for(int i=0; i<m_graph.size(); i++)
-        m_shortest[i] = INF;
+    m_matrix_ready = false;
+    m_use_tree = false;
+    m_repaired = false;
+}
+
+void DejikstraAlgorithm::setAllPairs(bool all_pairs)
+{
+    m_all_pairs = all_pairs;
+}
+
+void DejikstraAlgorithm::setHierarchy(bool hierarchy)
+{
+    m_hierarchy_enabled = hierarchy;
+}
+
+bool DejikstraAlgorithm::saveHierarchy(QIODevice *device,
+  const CSRGraph *graph)
+{
+    ContractionHierarchy hierarchy;
+    GraphicsView *view = MainWindow::instance().getView();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", false);
+
+    if (isRunning())
+        LOG_EXIT("Already running", false);
+
+    if (graph)
+    {
+        if (!hierarchy.build(*graph, nullptr))
+            LOG_EXIT("Can't build hierarchy", false);
+
+        return hierarchy.save(device);
+    }
+
+    if (m_hierarchy_version != view->getModel().version() ||
+         m_hierarchy.isEmpty())
+    {
+        if (!m_hierarchy.build(view->getModel().graph(), nullptr))
+            LOG_EXIT("Can't build hierarchy", false);
 
-    id = start->text().toInt() - 1;
-    visited[id] = true;
-    m_list.push_back(id);
+        m_hierarchy_version = view->getModel().version();
+    }
+
+    return m_hierarchy.save(device);
+}
+
+bool DejikstraAlgorithm::loadHierarchy(QIODevice *device)
+{
+    GraphicsView *view = MainWindow::instance().getView();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", false);
+
+    if (isRunning())
+        LOG_EXIT("Already running", false);
+
+    /* XXX: Data of another graph is rejected, the next run builds */
+    if (!m_hierarchy.load(device, view->getModel().graph()))
+    {
+        m_hierarchy_version = NoVersion;
+        return false;
+    }
+
+    m_hierarchy_version = view->getModel().version();
+
+    return true;
+}
+
+void DejikstraAlgorithm::setDynamic(bool dynamic)
+{
+    m_dynamic = dynamic;
+
+    if (!dynamic)
+        m_tree.clear();
+}
+
+QString DejikstraAlgorithm::matrixFile() const
+{
+    return QDir::temp().filePath("graph2d_distances.bin");
+}
+
+bool DejikstraAlgorithm::writeMatrix()
+{
+    AllPairs all(m_graph);
+
+    /* XXX: Shares the cancel flag and time budget of the run */
+    if (!all.write(matrixFile(), AllPairs::Auto,
+         [this](int steps) { return interrupted(steps); }))
+    {
+        LOG_EXIT("All pairs failed", false);
+    }
+
+    m_matrix_method = all.chosen();
+
+    return true;
+}
+
+void DejikstraAlgorithm::addPred(int node, int pred)
+{
+    m_pred_node.push_back(pred);
+    m_pred_next.push_back(m_pred_head.value(node));
+    m_pred_head.set(node, m_pred_node.size() - 1);
+}
+
+template<class Heap>
+bool DejikstraAlgorithm::search(Heap &heap, int start, int finish)
+{
+    bool found = false;
 
     /* XXX: Shortest way to start node is 0. */
-    m_shortest[id] = 0;
-    /* XXX: For graph debugging */
-    debug = true;
+    m_shortest.set(start, 0);
+    heap.push(0, start);
 
-    while(!m_list.isEmpty())
+    while(!heap.isEmpty() && !interrupted())
     {
-        Node *node;
-        int current = m_list.front();
+        int key, current;
+        const int *adj, *weights;
 
-        m_list.pop_front();
+        heap.pop(&key, &current);
 
-        /* Don't add finish node to m_way array! */
-        if (current != (finish->text().toInt() - 1))
-            m_way.push_back(new Vertex(current, false));
+        /* Stale entry, node was reached by a shorter way already */
+        if (m_settled.contains(current) || key > m_shortest.value(current))
+            continue;
+
+        m_settled.set(current, Forward);
+        m_explored++;
 
-        if (!(node = view->findNodeByIndex(current)))
+        /* XXX: Distance of finish node is final, nothing left to do */
+        if (current == finish)
         {
-            LOG_DEBUG("Node doesn't exist");
-            goto Exit;
+            found = true;
+            break;
         }
 
-        for(int i = 0; i<m_graph[current].size(); i++)
+        adj = m_graph.neighbors(current);
+        weights = m_graph.weights(current);
+
+        for(int k = 0; k<m_graph.degree(current); k++)
         {
-            int weight, sum = 0;
+            int i = adj[k]; /* connected with i-node */
+            int sum = weights[k] + m_shortest.value(current);
+
+            if (m_settled.contains(i))
+                continue;
 
-            if ((weight = m_graph[current][i])) /* if connectced with i-node */
+            /* XXX: Keep every equal-cost predecessor: they form a DAG
+             * of all the shortest ways */
+            if (sum < m_shortest.value(i))
             {
-                if (!(node = view->findNodeByIndex(i)))
-                {
-                    LOG_DEBUG("Node doesn't exist");
-                    goto Exit;
-                }
+                m_shortest.set(i, sum);
+                m_pred_head.set(i, -1);
+                addPred(i, current);
+                heap.push(sum, i);
+            }
+            else if (sum == m_shortest.value(i))
+                addPred(i, current);
+        }
+    }
 
-                sum = weight + m_shortest[current];
+    return found;
+}
 
-                if (sum < m_shortest[i])
-                    m_shortest[i] = sum;
+template<class Heap>
+bool DejikstraAlgorithm::bidirectionalSearch(Heap &forward, Heap &backward,
+  int start, int finish)
+{
+    int best = INF, meet_from = -1, meet_to = -1;
+    int last_forward = 0, last_backward = 0;
 
-                if ((node == finish) && !found)
-                    found = true;
+    m_reverse_shortest.reset(m_graph.size());
 
-                if (!visited[i]) /* if not visited yet */
-                {
-                    visited[i] = true;
-                    m_list.push_back(i);
-                }
-            }
-        }
-    }
+    m_shortest.set(start, 0);
+    m_reverse_shortest.set(finish, 0);
+    forward.push(0, start);
+    backward.push(0, finish);
 
-    if (found)
+    /* XXX: Grow the side with the smaller radius. Keys popped last are
+     * lower bounds of both queues, once their sum reaches the best way
+     * found so far, nothing shorter is left */
+    while(!forward.isEmpty() && !backward.isEmpty() && !interrupted())
     {
-        QVector<QVector<int> > ways = markWay(view, finish, true);
+        int key, current;
+        bool is_forward = last_forward <= last_backward;
+        Heap &heap = is_forward ? forward : backward;
+        const CSRGraph &graph = is_forward ? m_graph : m_reverse;
+        EpochArray &own = is_forward ? m_shortest : m_reverse_shortest;
+        EpochArray &other = is_forward ? m_reverse_shortest : m_shortest;
+        EpochArray &parent = is_forward ? m_parent : m_reverse_parent;
+        int bit = is_forward ? Forward : Backward;
+        const int *adj, *weights;
+
+        heap.pop(&key, &current);
+
+        if ((m_settled.value(current) & bit) || key > own.value(current))
+            continue;
+
+        if (is_forward)
+            last_forward = key;
+        else
+            last_backward = key;
+
+        if (last_forward + last_backward >= best)
+            break;
 
-        if (ways.isEmpty())
-            LOG_EXIT("Vector is empty", );
+        m_settled.set(current, m_settled.value(current) | bit);
+        m_explored++;
 
-        /* XXX: Create raport here! */
-        updateToolTips(view);
-        createRaport(start, view);
-        printWays(view, ways, finish);
+        adj = graph.neighbors(current);
+        weights = graph.weights(current);
+
+        for(int k = 0; k<graph.degree(current); k++)
+        {
+            int i = adj[k]; /* connected with i-node */
+            int sum = weights[k] + own.value(current);
+
+            if (sum < own.value(i))
+            {
+                own.set(i, sum);
+                parent.set(i, current);
+                heap.push(sum, i);
+            }
+
+            /* Reached by the other side, try the way through this arc */
+            if (other.value(i) != INF && sum + other.value(i) < best)
+            {
+                best = sum + other.value(i);
+                meet_from = is_forward ? current : i;
+                meet_to = is_forward ? i : current;
+            }
+        }
     }
-    else
-        MainWindow::instance().showMessage("Solution not found!");
 
-    if (debug)
+    if (best != INF)
     {
-        for(int i=0; i<m_graph.size(); i++)
-            qDebug() << m_shortest[i];
+        /* XXX: Only forward settled nodes have final distances, finish
+         * gets its one from the meeting arc */
+        m_shortest.set(finish, best);
+        m_settled.set(finish, m_settled.value(finish) | Forward);
+
+        return addMeetWay(start, meet_from, meet_to, finish);
     }
 
-  Exit:
-    delete[] visited;
-    delete[] m_shortest;
+    return false;
 }
 
-bool DejikstraAlgorithm::checkBranch(QVector<int> &marked, Node *finish,
- GraphicsView *view, bool reset)
+template<class Heap>
+bool DejikstraAlgorithm::searchWith(Heap *heaps, int start, int finish)
 {
-    int index;
-    Node *n1, *n2;
-    Edge *edge;
-    static int checksum = m_shortest[finish->text().toInt() - 1];
-    static QVector<size_t> weights;
-
-    if (reset)
+    /* XXX: Heaps live as long as the algorithm, clear() keeps storage */
+    for(int i=0; i<2; i++)
     {
-        checksum = m_shortest[finish->text().toInt() - 1];
-        weights.clear();
+        heaps[i].clear();
+        heaps[i].reserve(m_graph.size());
     }
 
-    if (marked.isEmpty())
-        LOG_EXIT("Empty array", false);
+    m_settled.reset(m_graph.size());
+    m_pred_head.reset(m_graph.size());
+    m_pred_node.clear();
+    m_pred_next.clear();
 
-    /* get index of value for m_way array */
-    if ((index = getIndex(marked.back())) == -1)
-        LOG_EXIT("Invalid index", false);
+    if (m_bidirectional)
+        return bidirectionalSearch(heaps[0], heaps[1], start, finish);
 
-    if(!(n1 = view->findNodeByIndex(marked.back())))
-        LOG_EXIT("Invalid pointer", false);
+    if (!search(heaps[0], start, finish))
+        return false;
 
-    if ((edge = n1->findConnectedEdge(finish)))
-    {
-        if (!(checksum - edge->getWeight()))
-            return true;
-    }
-    else
+    collectWays(start, finish);
+
+    return true;
+}
+
+void DejikstraAlgorithm::tightPreds(int finish)
+{
+    const CSRGraph &reverse = reverseGraph();
+    QVector<int> &stack = m_walk;
+
+    m_settled.reset(m_graph.size());
+    m_pred_head.reset(m_graph.size());
+    m_pred_node.clear();
+    m_pred_next.clear();
+
+    /* XXX: Walk back from finish over tight arcs, the ones shortest ways
+     * take. Zero weight arcs only as tree ones, they could close a loop */
+    stack.clear();
+    stack.push_back(finish);
+    m_settled.set(finish, Forward);
+
+    while(!stack.isEmpty())
     {
-        for(int i=index + 1; i<m_way.size(); i++)
+        int node = stack.back();
+        const int *adj = reverse.neighbors(node);
+        const int *weights = reverse.weights(node);
+
+        stack.pop_back();
+
+        for(int k=0; k<reverse.degree(node); k++)
         {
-            if (!(n2 = view->findNodeByIndex(m_way[i]->id)))
-                LOG_EXIT("Invalid pointer", false);
+            int pred = adj[k];
 
-            if ((edge = n1->findConnectedEdge(n2)) && !wasVisitedFromNode(index,
-                    m_way[i]))
+            if (m_tree.distance(pred) == INF ||
+                 m_tree.distance(pred) + weights[k] != m_tree.distance(node))
             {
-                marked.push_back(m_way[i]->id);
-                m_way[i]->visited_from.push_back(index);
-                weights.push_back(edge->getWeight());
-                checksum -= weights.at(weights.size() - 1);
-                return checkBranch(marked, finish, view, false);
+                continue;
+            }
+
+            if (!weights[k] && m_tree.parent(node) != pred)
+                continue;
+
+            addPred(node, pred);
+
+            if (!m_settled.contains(pred))
+            {
+                m_settled.set(pred, Forward);
+                stack.push_back(pred);
             }
         }
     }
+}
 
-    if (weights.isEmpty())
-        LOG_EXIT("Vector is empty", false);
+bool DejikstraAlgorithm::treeSearch(int start, int finish)
+{
+    m_use_tree = true;
+    m_repaired = m_tree.source() == start &&
+      m_tree.size() == m_graph.size() && m_changes_valid &&
+      m_changes_version == graphVersion();
+    m_repaired_from = m_repaired ? m_tree_version : NoVersion;
+
+    if (m_repaired)
+        m_tree.update(m_graph, reverseGraph(), m_changes);
+    else if (!m_tree.build(m_graph, start,
+               [this](int steps) { return interrupted(steps); }))
+    {
+        m_tree_version = NoVersion;
+        return false;
+    }
 
-    checksum += weights.at(weights.size() - 1);
-    weights.pop_back();
-    marked.pop_back();
+    /* XXX: Changes are used up, the next run asks for newer ones */
+    m_tree_version = graphVersion();
+    m_changes_valid = false;
+    m_explored += m_tree.work();
 
-    return checkBranch(marked, finish, view, false);
+    if (m_tree.distance(finish) == INF)
+        return false;
+
+    tightPreds(finish);
+    collectWays(start, finish);
+
+    return true;
 }
 
-bool DejikstraAlgorithm::wasVisitedFromNode(int from, Vertex *node) const
+bool DejikstraAlgorithm::hierarchySearch(int start, int finish)
 {
-    for(int i=0; i<node->visited_from.size(); i++)
+    QVector<int> &way = m_walk;
+    int distance;
+
+    /* XXX: Any edit makes the hierarchy stale, a graph given by
+     * setGraph() has no version to check, so it's built every run */
+    m_hierarchy_built = graphVersion() == NoVersion ||
+      m_hierarchy_version != graphVersion() ||
+      m_hierarchy.size() != m_graph.size();
+
+    if (m_hierarchy_built)
     {
-        if (node->visited_from[i] == from)
-            return true;
+        if (!m_hierarchy.build(m_graph,
+               [this](int steps) { return interrupted(steps); }))
+        {
+            m_hierarchy_version = NoVersion;
+            return false;
+        }
+
+        m_hierarchy_version = graphVersion();
     }
 
-    return false;
+    m_settled.reset(m_graph.size());
+    distance = m_hierarchy.query(start, finish, &way);
+    m_explored += m_hierarchy.explored();
+
+    if (distance == INF)
+        return false;
+
+    /* XXX: Only both ends have known distances, one way is shown */
+    m_settled.set(start, Forward);
+    m_shortest.set(start, 0);
+    m_settled.set(finish, Forward);
+    m_shortest.set(finish, distance);
+
+    m_ways.openWay();
+
+    for(int i=0; i<way.size(); i++)
+        m_ways.pushNode(way[i]);
+
+    m_ways.closeWay();
+
+    return true;
 }
 
-QVector<QVector<int> > DejikstraAlgorithm::markWay(GraphicsView *view,
-  Node *finish, bool reset)
+bool DejikstraAlgorithm::algorithm(int start, int finish, bool order)
 {
-    bool reset_color = true;
-    QVector<int> marked;
-    QVector<QVector<int> > result;
+    bool found = false;
+
+    /* XXX: Weights define the order, not the node ids */
+    Q_UNUSED(order);
 
-    if (m_way.isEmpty())
-        LOG_EXIT("Array is empty", QVector<QVector<int> >());
+    m_use_tree = false;
+    m_repaired = false;
+    m_hierarchy_built = false;
 
-    marked.push_back(m_way[0]->id);
+    /* XXX: Tree covers every node, a search stops at finish. Repair of
+     * the kept tree costs as much as the edits touched */
+    if (m_hierarchy_enabled && !m_all_pairs)
+        found = hierarchySearch(start, finish);
+    else if (m_dynamic && !m_bidirectional && !m_all_pairs)
+        found = treeSearch(start, finish);
+    else
+    {
+        switch (m_heap)
+        {
+            case PairingHeapID:
+            found = searchWith(m_pairing, start, finish);
+            break;
+
+            case RadixHeapID:
+            found = searchWith(m_radix, start, finish);
+            break;
+
+            case BinaryHeapID:
+            default:
+            found = searchWith(m_binary, start, finish);
+            break;
+        }
+    }
 
-    while(checkBranch(marked, finish, view, reset))
+    if (found && m_ways.isEmpty())
     {
-        markEdge(marked, finish, view, reset_color);
-        result.push_back(marked);
-        marked.clear();
-        marked.push_back(m_way[0]->id);
-        reset_color = false;
+        LOG_DEBUG("Vector is empty");
+        found = false;
     }
 
-    clearWay();
+    m_matrix_ready = found && m_all_pairs && writeMatrix();
 
-    return result;
+    return found;
 }
 
-void DejikstraAlgorithm::updateToolTips(GraphicsView *view) const
+void DejikstraAlgorithm::apply(GraphicsView *view, int start)
 {
-    QVector<Node*> nodes;
+    Node *first;
+    bool incremental;
 
     if (!view)
         LOG_EXIT("Invalid pointer!", );
 
+    if (!(first = view->findNodeByIndex(start)))
+        LOG_EXIT("Invalid pointer!", );
+
+    for(int i=0; i<m_ways.size(); i++)
+        markEdge(i, view, i);
+
+    /* XXX: A repaired tree differs from the shown one by changed() only */
+    incremental = m_use_tree && m_repaired &&
+      m_repaired_from != NoVersion && m_shown_version == m_repaired_from;
+
+    /* XXX: Create raport here! */
+    updateToolTips(view, incremental);
+
+    /* XXX: The matrix has the single source table as one of its rows */
+    if (m_matrix_ready)
+        showMatrix(first, view);
+    else
+        createRaport(first, view, incremental);
+
+    m_shown_version = m_use_tree && !m_matrix_ready ? m_tree_version :
+      NoVersion;
+
+    printWays(view);
+
+    MainWindow::instance().getRaport()->appendRaport(
+      QString("Explored: %1%2").arg(m_explored)
+      .arg(m_hierarchy_enabled && !m_all_pairs ?
+           (m_hierarchy_built ? " (hierarchy built)" : " (hierarchy)") :
+           m_bidirectional ? " (bidirectional)" :
+           m_repaired ? " (tree repaired)" : ""));
+}
+
+void DejikstraAlgorithm::showMatrix(Node *first, GraphicsView *view) const
+{
+    Raport *raport;
+    QVector<Node*> nodes;
+    QVector<QString> names(m_graph.size());
+
+    if (!view || !first)
+        LOG_EXIT("Invalid pointer!", );
+
     nodes = view->getNodes();
 
     for(int i=0; i<nodes.size(); i++)
     {
-        int path = m_shortest[nodes[i]->text().toInt() - 1];
+        if (nodes[i]->index() < names.size())
+            names[nodes[i]->index()] = nodeName(nodes[i]);
+    }
+
+    MainWindow::instance().createRaport();
+    raport = MainWindow::instance().getRaport();
+
+    raport->setRaport(QString("All pairs: %1, %2 nodes")
+      .arg(AllPairs::methodName((AllPairs::Method) m_matrix_method))
+      .arg(view->getNodes().size()));
+    raport->setMatrix(matrixFile(), names, first->index());
+}
+
+QString DejikstraAlgorithm::distance(int node) const
+{
+    if (m_use_tree)
+    {
+        if (node < 0 || node >= m_tree.size() || m_tree.distance(node) == INF)
+            return "-";
 
-        if (nodes[i]->toolTip().isEmpty())
-            nodes[i]->setToolTip(QString::number(path));
+        return QString::number(m_tree.distance(node));
+    }
+
+    /* XXX: Distances of not settled nodes are upper bounds only */
+    if (node < 0 || node >= m_settled.size() ||
+         !(m_settled.value(node) & Forward))
+    {
+        return "-";
+    }
+
+    return QString::number(m_shortest.value(node));
+}
+
+void DejikstraAlgorithm::collectWays(int start, int finish)
+{
+    QVector<int> &way = m_walk, &cursor = m_walk_cursor;
+
+    way.clear();
+    cursor.clear();
+
+    /* XXX: Iterative walk over predecessors DAG from finish to start.
+     * cursor[i] - next predecessor list entry of way[i] to try */
+    way.push_back(finish);
+    cursor.push_back(m_pred_head.value(finish));
+
+    while(!way.isEmpty() && m_ways.size() < MaxWays)
+    {
+        int node = way.back();
+
+        if (node == start)
+        {
+            m_ways.openWay();
+
+            for(int i=way.size() - 1; i>=0; i--)
+                m_ways.pushNode(way[i]);
+
+            m_ways.closeWay();
+            way.pop_back();
+            cursor.pop_back();
+        }
+        else if (cursor.back() != -1)
+        {
+            int pred = m_pred_node[cursor.back()];
+
+            cursor.back() = m_pred_next[cursor.back()];
+            way.push_back(pred);
+            cursor.push_back(m_pred_head.value(pred));
+        }
         else
         {
-            nodes[i]->setToolTip(nodes[i]->toolTip().split(",")[0] + ", " +
-             QString::number(path));
+            way.pop_back();
+            cursor.pop_back();
         }
     }
 }
 
-void DejikstraAlgorithm::createRaport(Node *first, GraphicsView *view) const
+void DejikstraAlgorithm::updateToolTips(GraphicsView *view,
+  bool incremental) const
 {
-    QString result, source, destination;
     QVector<Node*> nodes;
+    Node *node;
 
-    if (!view || !first)
+    if (!view)
         LOG_EXIT("Invalid pointer!", );
 
+    if (incremental)
+    {
+        const QVector<int> &changed = m_tree.changed();
+
+        for(int i=0; i<changed.size(); i++)
+        {
+            if ((node = view->findNodeByIndex(changed[i])))
+                setDistance(node, distance(changed[i]));
+        }
+
+        return;
+    }
+
     nodes = view->getNodes();
-    source = first->toolTip().isEmpty() ? first->text() :
-       first->toolTip().split(",")[0];
 
     for(int i=0; i<nodes.size(); i++)
+        setDistance(nodes[i], distance(nodes[i]->index()));
+}
+
+void DejikstraAlgorithm::createRaport(Node *first, GraphicsView *view,
+  bool incremental)
+{
+    QString result, source;
+    QVector<Node*> nodes;
+    Node *node;
+
+    if (!view || !first)
+        LOG_EXIT("Invalid pointer!", );
+
+    source = nodeName(first);
+
+    if (incremental)
     {
-        if (nodes[i] == first)
-            continue;
+        const QVector<int> &changed = m_tree.changed();
 
-        destination = nodes[i]->toolTip().isEmpty() ? nodes[i]->text() :
-           nodes[i]->toolTip().split(",")[0];
+        for(int i=0; i<changed.size(); i++)
+        {
+            if (changed[i] == first->index() ||
+                 changed[i] >= m_raport_lines.size() ||
+                 !(node = view->findNodeByIndex(changed[i])))
+            {
+                continue;
+            }
 
-        result += source + " - " + destination + " : " +
-         QString::number(m_shortest[nodes[i]->text().toInt() - 1]) + "<br/>";
+            m_raport_lines[changed[i]] = source + " - " + nodeName(node) +
+              " : " + distance(changed[i]) + "<br/>";
+        }
     }
+    else
+    {
+        nodes = view->getNodes();
+        m_raport_lines.fill(QString(), m_graph.size());
+        m_raport_order.clear();
+
+        for(int i=0; i<nodes.size(); i++)
+        {
+            int index = nodes[i]->index();
+
+            if (nodes[i] == first || index >= m_raport_lines.size())
+                continue;
+
+            m_raport_order.push_back(index);
+            m_raport_lines[index] = source + " - " + nodeName(nodes[i]) +
+              " : " + distance(index) + "<br/>";
+        }
+    }
+
+    /* XXX: Lines are only glued, none of the others is formatted again */
+    for(int i=0; i<m_raport_order.size(); i++)
+        result += m_raport_lines[m_raport_order[i]];
 
     MainWindow::instance().createRaport();
     MainWindow::instance().getRaport()->setRaport(result);
 }
 
-void DejikstraAlgorithm::printWays(GraphicsView *view,
-  QVector<QVector<int> > ways, Node *finish) const
+void DejikstraAlgorithm::printWays(GraphicsView *view) const
 {
     QString result;
 
-    if (!view || ways.isEmpty())
+    if (!view || m_ways.isEmpty())
         LOG_EXIT("Invalid parameter!", );
 
-    for(int i=0; i<ways.size(); i++)
+    for(int i=0; i<m_ways.size(); i++)
     {
+        const int *way = m_ways.nodes(i);
+
         result += "Way: ";
 
-        for(int j=0; j<ways[i].size(); j++)
+        for(int j=0; j<m_ways.length(i); j++)
         {
             Node *node;
 
-            if (!(node = view->findNodeByIndex(ways[i][j])))
+            if (!(node = view->findNodeByIndex(way[j])))
                 LOG_EXIT("Invalid pointer!", );
 
-            result += node->toolTip().split(",")[0] + " - ";
+            result += nodeName(node);
+            result += (j < m_ways.length(i) - 1) ? " - " : "<br/>";
         }
-
-        result += finish->toolTip().split(",")[0] + "<br/>";
     }
 
     MainWindow::instance().getRaport()->appendRaport(result);
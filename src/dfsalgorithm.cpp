@@ -1,7 +1,8 @@
 #include "dfsalgorithm.h"
 
 DFSAlgorithm::DFSAlgorithm(QObject *parent)
-    : AbstractAlgorithm(parent)
+    : AbstractAlgorithm(parent),
+      m_cursor(0)
 {
 
 }
@@ -11,101 +12,88 @@ DFSAlgorithm::~DFSAlgorithm()
 
 }
 
-void DFSAlgorithm::algorithm(Node *start, Node *finish, GraphicsView *view,
-  bool order)
+void DFSAlgorithm::configure(Tab *tab)
 {
-    int id;
-    bool debug, reset, found = false;
-    bool *visited = new bool[m_graph.size()]();
+    AbstractAlgorithm::configure(tab);
 
-    if (!visited)
-    {
-        LOG_DEBUG("Invalid pointer");
-    }
+    /* XXX: There is no meet in the middle for DFS */
+    m_bidirectional = false;
+}
+
+QVector<int> DFSAlgorithm::getDiscovery() const
+{
+    return m_discovery.toVector();
+}
+
+QVector<int> DFSAlgorithm::getFinish() const
+{
+    return m_finish.toVector();
+}
+
+bool DFSAlgorithm::algorithm(int start, int finish, bool order)
+{
+    int size = m_graph.size(), time = 0, top = 0;
+    bool found = false;
+    int *stack;
+
+    m_discovery.reset(size);
+    m_finish.reset(size);
+    m_cursor.reset(size);
+
+    /* XXX: Stack holds one path, it can't be deeper than node count */
+    if (m_stack.size() < size)
+        m_stack.resize(size);
 
-    id = start->text().toInt() - 1;
-    visited[id] = reset = true;
-    m_list.push_front(id);
+    stack = m_stack.data();
 
-    /* XXX: For graph debugging */
-    debug = true;
+    stack[top++] = start;
+    m_discovery.set(start, time++);
+    m_raport.push_back(start);
+    m_explored++;
 
-    while(!m_list.isEmpty())
+    while(top && !interrupted())
     {
-        Node *node;
-        int current = m_list.front();
+        int current = stack[top - 1], i = -1;
+        const int *adj = m_graph.neighbors(current);
+        int degree = m_graph.degree(current);
 
-        m_list.pop_front();
-        m_way.push_back(new Vertex(current, false));
+        /* XXX: Cursor counts checked arcs, row is walked from its head
+         * or from its tail depending on the order */
+        int k = m_cursor.value(current);
 
-        if (!(node = view->findNodeByIndex(current)))
+        while(k < degree && i == -1)
         {
-            LOG_DEBUG("Node doesn't exist");
-            goto Exit;
+            int next = adj[order ? k : degree - 1 - k];
+
+            k++;
+
+            if (!m_discovery.contains(next)) /* if not visited yet */
+                i = next;
         }
 
-        if (debug)
-            m_debug.push_back(current + 1);
+        m_cursor.set(current, k);
 
-        /* Mark opened nodes until not found connected one */
-        if (!found)
+        if (i == -1) /* all connected nodes are done, step back */
         {
-            if (node != start)
-                node->setBrush(QBrush(Qt::yellow, Qt::SolidPattern));
-
-            m_raport.push_back(current + 1);
+            m_finish.set(current, time++);
+            top--;
+            continue;
         }
 
-        for(int i = order ? 0 : m_graph[current].size() - 1;
-            order ? (i<m_graph[current].size()) : (i>=0) ; order ? i++ : i--)
+        m_parent.set(i, current);
+        m_discovery.set(i, time++);
+
+        if (i == finish)
         {
-            if (m_graph[current][i]) /* if connectced with i-node */
-            {
-                if (!(node = view->findNodeByIndex(i)))
-                {
-                    LOG_DEBUG("Node doesn't exist");
-                    goto Exit;
-                }
-
-            /* XXX: Workaround: Found only one way
-             * After found way, algorithm not stoping.
-             * We continue opening all nodes. This is important in case
-             * if want mark more than one way from start to finish point later. */
-                if ((node == finish) && !found)
-                {
-                    QVector<int> marked = markWay(view, finish, reset);
-
-                    if (marked.isEmpty())
-                        LOG_EXIT("Vector is empty", );
-
-                    /* XXX: Workaround */
-                    for(int i=0; i<marked.size(); i++)
-                        marked[i]++;
-
-                    found = true;
-                    reset = false;
-
-                    MainWindow::instance().createRaport();
-                    MainWindow::instance().getRaport()->setRaport(m_raport);
-                    MainWindow::instance().getRaport()->appendRaport(marked,
-               "Way: ");
-                }
-
-                if (!visited[i]) /* if not visited yet */
-                {
-                    visited[i] = true;
-                    m_list.push_front(i);
-                }
-            }
+            found = true;
+            break;
         }
-    }
 
-    if (!found)
-        MainWindow::instance().showMessage("Solution not found!");
-
-    if (debug)
-        qDebug() << m_debug;
+        /* Remember opened nodes until not found connected one */
+        m_raport.push_back(i);
+        m_explored++;
+        stack[top++] = i;
+    }
 
-  Exit:
-    delete[] visited;
+    return found && addWay(start, finish);
 }
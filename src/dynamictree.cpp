@@ -0,0 +1,270 @@
+#include "dynamictree.h"
+#include "log.h"
+
+#ifndef INF
+#define INF INT32_MAX
+#endif
+
+DynamicTree::DynamicTree()
+    : m_touched(0),
+      m_source(-1),
+      m_work(0)
+{
+
+}
+
+DynamicTree::~DynamicTree()
+{
+
+}
+
+void DynamicTree::clear()
+{
+    m_distance.clear();
+    m_parent.clear();
+    m_child.clear();
+    m_next.clear();
+    m_prev.clear();
+    m_heap.clear();
+    m_changed.clear();
+    m_stack.clear();
+    m_cut.clear();
+    m_source = -1;
+    m_work = 0;
+}
+
+int DynamicTree::source() const
+{
+    return m_source;
+}
+
+int DynamicTree::size() const
+{
+    return m_distance.size();
+}
+
+const QVector<int> &DynamicTree::changed() const
+{
+    return m_changed;
+}
+
+int DynamicTree::work() const
+{
+    return m_work;
+}
+
+bool DynamicTree::build(const CSRGraph &graph, int source,
+  std::function<bool(int)> stop)
+{
+    int size = graph.size();
+
+    clear();
+
+    if (source < 0 || source >= size)
+        LOG_EXIT("Invalid source:" << source, false);
+
+    m_distance.fill(INF, size);
+    m_parent.fill(-1, size);
+    m_child.fill(-1, size);
+    m_next.fill(-1, size);
+    m_prev.fill(-1, size);
+    m_touched.reset(size);
+    m_heap.reserve(size);
+    m_source = source;
+
+    lower(source, -1, 0);
+
+    if (!settle(graph, stop))
+    {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+void DynamicTree::update(const CSRGraph &graph, const CSRGraph &reverse,
+  const QVector<arc_change_t> &changes)
+{
+    if (m_source == -1 || graph.size() != size() ||
+         reverse.size() != size())
+    {
+        LOG_EXIT("Tree doesn't match the graph", );
+    }
+
+    m_touched.reset(size());
+    m_changed.clear();
+    m_heap.clear();
+    m_cut.clear();
+    m_work = 0;
+
+    /* XXX: Checked against the final graph, so a few edits of one arc in
+     * a row act as one. Only a tree arc that is gone or got dearer takes
+     * down the subtree under it, a cheaper one is relaxed below. A parent
+     * cut before makes its children roots of nothing, they went down with
+     * it already */
+    for(int c=0; c<changes.size(); c++)
+    {
+        int from = changes[c].from, to = changes[c].to;
+
+        if (from >= size() || to >= size() || m_parent[to] != from)
+            continue;
+
+        if (!graph.contains(from, to) ||
+             m_distance[from] + graph.weight(from, to) > m_distance[to])
+        {
+            cutSubtree(to);
+        }
+    }
+
+    /* XXX: Cut nodes start from the best arc coming from the rest */
+    for(int i=0; i<m_cut.size(); i++)
+    {
+        int node = m_cut[i];
+        const int *adj = reverse.neighbors(node);
+        const int *weights = reverse.weights(node);
+
+        for(int k=0; k<reverse.degree(node); k++)
+        {
+            if (m_distance[adj[k]] == INF)
+                continue;
+
+            if (m_distance[adj[k]] + weights[k] < m_distance[node])
+                lower(node, adj[k], m_distance[adj[k]] + weights[k]);
+        }
+    }
+
+    /* XXX: Cheaper and new arcs lower their heads, the gain spreads from
+     * there, nothing is cut */
+    for(int c=0; c<changes.size(); c++)
+    {
+        int from = changes[c].from, to = changes[c].to;
+
+        if (from >= size() || to >= size() || m_distance[from] == INF ||
+             !graph.contains(from, to))
+        {
+            continue;
+        }
+
+        if (m_distance[from] + graph.weight(from, to) < m_distance[to])
+            lower(to, from, m_distance[from] + graph.weight(from, to));
+    }
+
+    m_work += m_cut.size();
+    settle(graph, nullptr);
+}
+
+void DynamicTree::link(int node, int parent)
+{
+    m_parent[node] = parent;
+    m_prev[node] = -1;
+    m_next[node] = m_child[parent];
+
+    if (m_child[parent] != -1)
+        m_prev[m_child[parent]] = node;
+
+    m_child[parent] = node;
+}
+
+void DynamicTree::unlink(int node)
+{
+    int parent = m_parent[node];
+
+    if (parent == -1)
+        return;
+
+    if (m_prev[node] != -1)
+        m_next[m_prev[node]] = m_next[node];
+    else
+        m_child[parent] = m_next[node];
+
+    if (m_next[node] != -1)
+        m_prev[m_next[node]] = m_prev[node];
+
+    m_parent[node] = -1;
+    m_prev[node] = -1;
+    m_next[node] = -1;
+}
+
+void DynamicTree::touch(int node)
+{
+    if (m_touched.contains(node))
+        return;
+
+    m_touched.set(node, 1);
+    m_changed.push_back(node);
+}
+
+void DynamicTree::lower(int node, int parent, int distance)
+{
+    m_distance[node] = distance;
+    unlink(node);
+
+    if (parent != -1)
+        link(node, parent);
+
+    touch(node);
+    m_heap.push(distance, node);
+}
+
+void DynamicTree::cutSubtree(int root)
+{
+    unlink(root);
+    m_stack.clear();
+    m_stack.push_back(root);
+
+    /* XXX: Iterative, a tree of a long path would blow the call stack */
+    while(!m_stack.isEmpty())
+    {
+        int node = m_stack.back(), child = m_child[node];
+
+        m_stack.pop_back();
+        m_distance[node] = INF;
+        m_cut.push_back(node);
+        touch(node);
+
+        while(child != -1)
+        {
+            int next = m_next[child];
+
+            m_parent[child] = -1;
+            m_prev[child] = -1;
+            m_next[child] = -1;
+            m_stack.push_back(child);
+            child = next;
+        }
+
+        m_child[node] = -1;
+    }
+}
+
+bool DynamicTree::settle(const CSRGraph &graph, std::function<bool(int)> stop)
+{
+    while(!m_heap.isEmpty())
+    {
+        int key, current;
+        const int *adj, *weights;
+
+        m_heap.pop(&key, &current);
+
+        /* Stale entry, node was lowered again after the push */
+        if (key > m_distance[current])
+            continue;
+
+        m_work++;
+
+        if (stop && stop(1))
+            return false;
+
+        adj = graph.neighbors(current);
+        weights = graph.weights(current);
+
+        for(int k=0; k<graph.degree(current); k++)
+        {
+            if (key + weights[k] < m_distance[adj[k]])
+                lower(adj[k], current, key + weights[k]);
+        }
+    }
+
+    return true;
+}
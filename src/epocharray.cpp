@@ -0,0 +1,51 @@
+#include "epocharray.h"
+
+EpochArray::EpochArray(int empty)
+    : m_values(0),
+      m_stamps(0),
+      m_epoch(0),
+      m_size(0),
+      m_empty(empty)
+{
+
+}
+
+EpochArray::~EpochArray()
+{
+
+}
+
+void EpochArray::reset(int size)
+{
+    if (size > m_values.size())
+    {
+        m_values.resize(size);
+        m_stamps.fill(0, size);
+        m_epoch = 0;
+    }
+
+    m_size = size;
+
+    /* XXX: After a wrap old stamps would match again, clear them once
+     * per 2^32 runs */
+    if (!++m_epoch)
+    {
+        m_stamps.fill(0);
+        m_epoch = 1;
+    }
+}
+
+int EpochArray::size() const
+{
+    return m_size;
+}
+
+QVector<int> EpochArray::toVector() const
+{
+    QVector<int> result(m_size);
+
+    for(int i=0; i<m_size; i++)
+        result[i] = value(i);
+
+    return result;
+}
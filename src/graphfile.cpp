@@ -0,0 +1,496 @@
+#include <cstring>
+
+#include "graphfile.h"
+#include "log.h"
+
+GraphFile::GraphFile()
+    : m_data(nullptr),
+      m_header(nullptr),
+      m_toc(nullptr),
+      m_topology(Unchecked),
+      m_layout(Unchecked),
+      m_labels(Unchecked),
+      m_nodes(0),
+      m_arcs(0),
+      m_offsets(nullptr),
+      m_neighbors(nullptr),
+      m_weights(nullptr),
+      m_positions(nullptr),
+      m_label_offsets(nullptr),
+      m_text(nullptr)
+{
+
+}
+
+GraphFile::~GraphFile()
+{
+    close();
+    cancel();
+}
+
+bool GraphFile::open(QString filename)
+{
+    qint64 size;
+
+    close();
+    m_file.setFileName(filename);
+
+    if (!m_file.open(QIODevice::ReadOnly))
+        LOG_EXIT("Can't open file:" << filename, false);
+
+    size = m_file.size();
+
+    if (size < (qint64) sizeof(graph_file_header_t) ||
+         !(m_data = m_file.map(0, size)))
+    {
+        close();
+        LOG_EXIT("Can't map file:" << filename, false);
+    }
+
+    m_header = (const graph_file_header_t*) m_data;
+
+    /* XXX: The table closes the file, so a cut file loses it */
+    if (memcmp(m_header->magic, GRAPH_FILE_MAGIC, sizeof(m_header->magic)) ||
+         m_header->version != GRAPH_FILE_VERSION ||
+         m_header->sections < 0 || m_header->size != size ||
+         m_header->toc < (qint64) sizeof(graph_file_header_t) ||
+         m_header->toc % Alignment ||
+         m_header->toc + m_header->sections * (qint64) sizeof(graph_section_t)
+           != size)
+    {
+        close();
+        LOG_EXIT("Invalid file:" << filename, false);
+    }
+
+    m_toc = (const graph_section_t*) (m_data + m_header->toc);
+
+    for(int i=0; i<m_header->sections; i++)
+    {
+        if (m_toc[i].offset < (qint64) sizeof(graph_file_header_t) ||
+             m_toc[i].offset % Alignment || m_toc[i].size < 0 ||
+             m_toc[i].size > m_header->toc - m_toc[i].offset)
+        {
+            close();
+            LOG_EXIT("Invalid section in:" << filename, false);
+        }
+    }
+
+    return true;
+}
+
+void GraphFile::close()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_data = nullptr;
+    m_header = nullptr;
+    m_toc = nullptr;
+    m_topology = Unchecked;
+    m_layout = Unchecked;
+    m_labels = Unchecked;
+    m_nodes = 0;
+    m_arcs = 0;
+    m_offsets = nullptr;
+    m_neighbors = nullptr;
+    m_weights = nullptr;
+    m_positions = nullptr;
+    m_label_offsets = nullptr;
+    m_text = nullptr;
+}
+
+bool GraphFile::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+const graph_section_t *GraphFile::find(const char *tag) const
+{
+    if (!isOpen())
+        return nullptr;
+
+    for(int i=0; i<m_header->sections; i++)
+    {
+        if (!memcmp(m_toc[i].tag, tag, sizeof(m_toc[i].tag)))
+            return &m_toc[i];
+    }
+
+    return nullptr;
+}
+
+bool GraphFile::hasSection(const char *tag) const
+{
+    return find(tag) != nullptr;
+}
+
+QByteArray GraphFile::section(const char *tag) const
+{
+    const graph_section_t *section = find(tag);
+
+    if (!section)
+        return QByteArray();
+
+    return QByteArray::fromRawData((const char*) m_data + section->offset,
+      section->size);
+}
+
+bool GraphFile::checkTopology() const
+{
+    const graph_section_t *section;
+    const qint32 *counts;
+
+    if (m_topology != Unchecked)
+        return m_topology == Valid;
+
+    m_topology = Invalid;
+
+    if (!(section = find(GRAPH_SECTION_TOPOLOGY)) ||
+         section->size < (qint64) (2 * sizeof(qint32)))
+    {
+        LOG_EXIT("No topology", false);
+    }
+
+    counts = (const qint32*) (m_data + section->offset);
+
+    if (counts[0] <= 0 || counts[1] < 0 || section->size !=
+         (2 + (qint64) counts[0] + 1 + 2 * (qint64) counts[1]) *
+           (qint64) sizeof(qint32))
+    {
+        LOG_EXIT("Invalid topology size", false);
+    }
+
+    m_offsets = counts + 2;
+    m_neighbors = m_offsets + counts[0] + 1;
+    m_weights = m_neighbors + counts[1];
+
+    /* XXX: Everything else reads the arrays unchecked, so a broken row
+     * must not get past here */
+    if (m_offsets[0] != 0 || m_offsets[counts[0]] != counts[1])
+        LOG_EXIT("Invalid topology", false);
+
+    for(int i=0; i<counts[0]; i++)
+    {
+        if (m_offsets[i + 1] < m_offsets[i])
+            LOG_EXIT("Invalid row:" << i, false);
+
+        for(int k=m_offsets[i]; k<m_offsets[i + 1]; k++)
+        {
+            if (m_neighbors[k] < 0 || m_neighbors[k] >= counts[0] ||
+                 m_weights[k] < 0)
+            {
+                LOG_EXIT("Invalid arc of row:" << i, false);
+            }
+
+            /* Rows are sorted and free of duplicates */
+            if (k > m_offsets[i] && m_neighbors[k] <= m_neighbors[k - 1])
+                LOG_EXIT("Unsorted row:" << i, false);
+        }
+    }
+
+    m_nodes = counts[0];
+    m_arcs = counts[1];
+    m_topology = Valid;
+
+    return true;
+}
+
+bool GraphFile::checkLayout() const
+{
+    const graph_section_t *section;
+
+    if (m_layout != Unchecked)
+        return m_layout == Valid;
+
+    m_layout = Invalid;
+
+    if (!checkTopology())
+        return false;
+
+    if (!(section = find(GRAPH_SECTION_LAYOUT)) ||
+         section->size != m_nodes * 2 * (qint64) sizeof(double))
+    {
+        LOG_EXIT("No layout", false);
+    }
+
+    m_positions = (const double*) (m_data + section->offset);
+    m_layout = Valid;
+
+    return true;
+}
+
+bool GraphFile::checkLabels() const
+{
+    const graph_section_t *section;
+    qint64 table;
+
+    if (m_labels != Unchecked)
+        return m_labels == Valid;
+
+    m_labels = Invalid;
+
+    if (!checkTopology())
+        return false;
+
+    table = (m_nodes + 1) * (qint64) sizeof(qint32);
+
+    if (!(section = find(GRAPH_SECTION_LABELS)) || section->size < table)
+        LOG_EXIT("No labels", false);
+
+    m_label_offsets = (const qint32*) (m_data + section->offset);
+    m_text = (const char*) (m_data + section->offset + table);
+
+    if (m_label_offsets[0] != 0 ||
+         m_label_offsets[m_nodes] != section->size - table)
+    {
+        LOG_EXIT("Invalid labels", false);
+    }
+
+    for(int i=0; i<m_nodes; i++)
+    {
+        if (m_label_offsets[i + 1] < m_label_offsets[i])
+            LOG_EXIT("Invalid label:" << i, false);
+    }
+
+    m_labels = Valid;
+
+    return true;
+}
+
+int GraphFile::size() const
+{
+    return checkTopology() ? m_nodes : 0;
+}
+
+int GraphFile::arcCount() const
+{
+    return checkTopology() ? m_arcs : 0;
+}
+
+CSRGraph GraphFile::graph() const
+{
+    CSRGraph graph;
+
+    if (checkTopology())
+        graph.assign(m_nodes, m_offsets, m_neighbors, m_weights);
+
+    return graph;
+}
+
+QPointF GraphFile::position(int node) const
+{
+    if (!checkLayout() || node < 0 || node >= m_nodes)
+        return QPointF();
+
+    return QPointF(m_positions[2 * node], m_positions[2 * node + 1]);
+}
+
+QString GraphFile::label(int node) const
+{
+    if (!checkLabels() || node < 0 || node >= m_nodes)
+        return QString();
+
+    return QString::fromUtf8(m_text + m_label_offsets[node],
+      m_label_offsets[node + 1] - m_label_offsets[node]);
+}
+
+bool GraphFile::create(QString filename)
+{
+    graph_file_header_t header;
+
+    cancel();
+    m_sections.clear();
+    m_save.setFileName(filename);
+
+    if (!m_save.open(QIODevice::WriteOnly))
+        LOG_EXIT("Can't open file:" << filename, false);
+
+    /* XXX: Placeholder, commit() writes the real one */
+    memset(&header, 0, sizeof(header));
+
+    if (!writeData(&header, sizeof(header)))
+    {
+        cancel();
+        return false;
+    }
+
+    return true;
+}
+
+bool GraphFile::writeData(const void *data, qint64 size)
+{
+    if (!size)
+        return true;
+
+    if (m_save.write((const char*) data, size) != size)
+        LOG_EXIT("Can't write file:" << m_save.fileName(), false);
+
+    return true;
+}
+
+bool GraphFile::beginSection(const char *tag)
+{
+    static const char padding[Alignment] = { 0 };
+    graph_section_t section;
+
+    if (!m_save.isOpen())
+        LOG_EXIT("File isn't created", false);
+
+    if (!writeData(padding, (Alignment - m_save.pos() % Alignment) %
+           Alignment))
+    {
+        return false;
+    }
+
+    memcpy(section.tag, tag, sizeof(section.tag));
+    section.reserved = 0;
+    section.offset = m_save.pos();
+    section.size = 0;
+    m_sections.push_back(section);
+
+    return true;
+}
+
+bool GraphFile::endSection()
+{
+    m_sections.back().size = m_save.pos() - m_sections.back().offset;
+
+    return true;
+}
+
+bool GraphFile::writeSection(const char *tag, const QByteArray &data)
+{
+    return beginSection(tag) && writeData(data.constData(), data.size()) &&
+      endSection();
+}
+
+bool GraphFile::writeGraph(const GraphModel &model,
+  const QVector<QString> &labels)
+{
+    const CSRGraph &graph = model.graph();
+    QVector<int> ids(graph.size(), -1);
+    QVector<double> positions;
+    QVector<qint32> counts(2), offsets, neighbors, weights, label_offsets;
+    QByteArray text;
+    int nodes = 0;
+
+    if (!model.nodeCount())
+        LOG_EXIT("Graph is empty", false);
+
+    for(int i=0; i<graph.size(); i++)
+    {
+        if (model.isNode(i))
+            ids[i] = nodes++;
+    }
+
+    offsets.reserve(nodes + 1);
+    label_offsets.reserve(nodes + 1);
+    positions.reserve(2 * nodes);
+    neighbors.reserve(graph.arcCount());
+    weights.reserve(graph.arcCount());
+    offsets.push_back(0);
+    label_offsets.push_back(0);
+
+    /* XXX: Renumbering keeps the id order, so sorted rows stay sorted */
+    for(int i=0; i<graph.size(); i++)
+    {
+        const int *adj = graph.neighbors(i);
+        const int *w = graph.weights(i);
+
+        if (ids[i] == -1)
+            continue;
+
+        for(int k=0; k<graph.degree(i); k++)
+        {
+            neighbors.push_back(ids[adj[k]]);
+            weights.push_back(w[k]);
+        }
+
+        offsets.push_back(neighbors.size());
+        positions.push_back(model.position(i).x());
+        positions.push_back(model.position(i).y());
+
+        if (i < labels.size())
+            text.append(labels[i].toUtf8());
+
+        label_offsets.push_back(text.size());
+    }
+
+    counts[0] = nodes;
+    counts[1] = neighbors.size();
+    m_written.assign(nodes, offsets.constData(), neighbors.constData(),
+      weights.constData());
+
+    return beginSection(GRAPH_SECTION_TOPOLOGY) &&
+      writeData(counts.constData(), counts.size() * sizeof(qint32)) &&
+      writeData(offsets.constData(), offsets.size() * sizeof(qint32)) &&
+      writeData(neighbors.constData(), neighbors.size() * sizeof(qint32)) &&
+      writeData(weights.constData(), weights.size() * sizeof(qint32)) &&
+      endSection() &&
+      beginSection(GRAPH_SECTION_LAYOUT) &&
+      writeData(positions.constData(), positions.size() * sizeof(double)) &&
+      endSection() &&
+      beginSection(GRAPH_SECTION_LABELS) &&
+      writeData(label_offsets.constData(),
+        label_offsets.size() * sizeof(qint32)) &&
+      writeData(text.constData(), text.size()) &&
+      endSection();
+}
+
+const CSRGraph &GraphFile::writtenGraph() const
+{
+    return m_written;
+}
+
+bool GraphFile::commit()
+{
+    static const char padding[Alignment] = { 0 };
+    graph_file_header_t header;
+
+    if (!m_save.isOpen())
+        LOG_EXIT("File isn't created", false);
+
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.sections = m_sections.size();
+    header.reserved = 0;
+
+    if (!writeData(padding, (Alignment - m_save.pos() % Alignment) %
+           Alignment))
+    {
+        cancel();
+        return false;
+    }
+
+    header.toc = m_save.pos();
+    header.size = header.toc + m_sections.size() * sizeof(graph_section_t);
+
+    if (!writeData(m_sections.constData(),
+           m_sections.size() * sizeof(graph_section_t)) ||
+         !m_save.seek(0) || !writeData(&header, sizeof(header)))
+    {
+        cancel();
+        return false;
+    }
+
+    m_sections.clear();
+
+    /* XXX: Syncs the temporary file and renames it over the target */
+    if (!m_save.commit())
+        LOG_EXIT("Can't commit file:" << m_save.fileName(), false);
+
+    return true;
+}
+
+void GraphFile::cancel()
+{
+    if (!m_save.isOpen())
+        return;
+
+    /* XXX: The temporary file goes, the old one is left as it was */
+    m_save.cancelWriting();
+    m_save.commit();
+    m_sections.clear();
+}
@@ -1,5 +1,13 @@
+#include <algorithm>
+#include <functional>
+
 #include "graphicsview.h"
 
+static quint64 arcKey(int from, int to)
+{
+    return ((quint64) (quint32) from << 32) | (quint32) to;
+}
+
 str2mode_t str2mode_arr[] = {
   { .str = "Connect...", .mode = Connecting },
   { .str = "Move...", .mode = Moving },
@@ -74,9 +82,16 @@ size_t GraphicsView::horizontalOffset() const
 
 bool GraphicsView::isNodeIntersected(QRectF rect) const
 {
-    for(int i=0; i<m_nodes.size(); i++)
+    /* XXX: The scene's BSP index finds the few items around, a loop over
+     * all nodes made every upload O(V^2) */
+    QList<QGraphicsItem*> items = m_scene->items(rect,
+      Qt::IntersectsItemBoundingRect);
+
+    for(int i=0; i<items.size(); i++)
     {
-        if (rect.intersects(m_nodes[i]->rect()))
+        Node *node = dynamic_cast<Node*> (items[i]);
+
+        if (node && rect.intersects(node->rect()))
             return true;
     }
 
@@ -126,64 +141,133 @@ void GraphicsView::directableEdge(Edge *edge)
 
     if (!node || !node->delEdge(edge))
         LOG_DEBUG("Invalid parameter: " << (void*) node);
+    else
+        directEdge((node == vertices.first) ? vertices.second : vertices.first,
+          node);
 
     setMode(Default);
 }
 
-void GraphicsView::restoreEdges(QVector<QVector<int> > graph)
+void GraphicsView::restoreEdges(const CSRGraph &graph)
 {
     Node *row, *col;
     Edge *edge;
-    int current;
 
     if (graph.isEmpty())
-        LOG_EXIT("Vector is empty", );
+        LOG_EXIT("Graph is empty", );
 
+    /* XXX: O(V + E), arcs are walked as they are, no matrix */
     for(int i=0; i<graph.size(); i++)
     {
+        const int *adj = graph.neighbors(i);
+        const int *weights = graph.weights(i);
+
         if(!(row = findNodeByIndex(i)))
             LOG_EXIT("Invalid pointer", );
 
-        for(int j=0; j<graph[i].size(); j++)
+        for(int k=0; k<graph.degree(i); k++)
         {
-            if ((current = graph[i][j]))
-            {
-                if (!(col = findNodeByIndex(j)))
-                    LOG_EXIT("Invalid pointer", );
+            if (!(col = findNodeByIndex(adj[k])))
+                LOG_EXIT("Invalid pointer", );
 
-                if (row->isAmongNeighbors(col))
-                    continue;
+            /* Reverse arc of an undirected edge made already */
+            if (findEdge(row, col))
+                continue;
 
-                edge = addEdge(row->rect().center().x(), row->rect().center().y(),
-                       col->rect().center().x(), col->rect().center().y(),
-                       row, col);
+            edge = addEdge(row->rect().center().x(), row->rect().center().y(),
+                   col->rect().center().x(), col->rect().center().y(),
+                   row, col);
 
-                if (current > 1)
-                    edge->setWeight(current);
+            if (weights[k] > 1)
+                edge->setWeight(weights[k]);
 
-                row->addNeighbor(col);
+            row->addNeighbor(col);
+            registerEdge(edge);
 
-                if (graph[j][i])
-                {
-                    col->addEdge(row, col, &edge);
-                    col->addNeighbor(row);
-                }
-                else
-                    edge->directable(true);
+            if (graph.contains(adj[k], i))
+            {
+                col->addEdge(row, col, &edge);
+                col->addNeighbor(row);
+            }
+            else
+            {
+                edge->directable(true);
+                directEdge(row, col);
             }
         }
     }
 }
 
+void GraphicsView::loadGraph(const CSRGraph &graph)
+{
+    deleteAll();
+    m_model.assign(graph);
+}
+
+bool GraphicsView::isHeadless() const
+{
+    return m_model.nodeCount() > m_nodes.size();
+}
+
 Node* GraphicsView::findNodeByName(int name) const
 {
-    for(int i=0; i<m_nodes.size(); i++)
+    return findNodeByIndex(name - 1);
+}
+
+int GraphicsView::nextNodeIndex() const
+{
+    /* XXX: The smallest free id, so uploaded graphs get names 1..N again */
+    return m_free_ids.isEmpty() ? m_index.size() : m_free_ids.front();
+}
+
+void GraphicsView::indexNode(Node *node)
+{
+    int id = node->index();
+
+    if (id < 0)
+        LOG_EXIT("Invalid index", );
+
+    while (id >= m_index.size())
     {
-        if (m_nodes[i]->text().toInt() == name)
-            return m_nodes[i];
+        m_free_ids.push_back(m_index.size());
+        std::push_heap(m_free_ids.begin(), m_free_ids.end(), std::greater<int>());
+        m_index.push_back(nullptr);
     }
 
-    return nullptr;
+    if (m_index[id])
+        LOG_EXIT("Index is busy:" << id, );
+
+    m_index[id] = node;
+
+    if (!m_free_ids.isEmpty() && m_free_ids.front() == id)
+    {
+        std::pop_heap(m_free_ids.begin(), m_free_ids.end(), std::greater<int>());
+        m_free_ids.pop_back();
+    }
+    else
+    {
+        int pos = m_free_ids.indexOf(id);
+
+        /* XXX: Not the smallest one. Rare, take it out and rebuild the heap */
+        if (pos != -1)
+        {
+            m_free_ids.remove(pos);
+            std::make_heap(m_free_ids.begin(), m_free_ids.end(),
+              std::greater<int>());
+        }
+    }
+}
+
+void GraphicsView::unindexNode(Node *node)
+{
+    int id = node->index();
+
+    if (id < 0 || id >= m_index.size() || m_index[id] != node)
+        LOG_EXIT("Node isn't indexed", );
+
+    m_index[id] = nullptr;
+    m_free_ids.push_back(id);
+    std::push_heap(m_free_ids.begin(), m_free_ids.end(), std::greater<int>());
 }
 
 void GraphicsView::deleteAll()
@@ -192,6 +276,10 @@ void GraphicsView::deleteAll()
     deleteNode(*m_nodes.begin());
 
     m_nodes.clear();
+    m_model.clear();
+    m_edge_index.clear();
+    m_index.clear();
+    m_free_ids.clear();
     m_scene->clear();
     m_selected_edge = nullptr;
     m_selected_node = nullptr;
@@ -210,7 +298,14 @@ void GraphicsView::setEdgeWeight(Edge *edge)
                "Weight: ", &ok);
 
     if (ok && isStringValid(weight, "^[0-9]{1,3}$"))
+    {
+        QPair<Node*, Node*> vertices;
+
         edge->setWeight(weight.toUInt());
+        vertices = edge->getVertices();
+        m_model.setWeight(vertices.first->index(), vertices.second->index(),
+          edge->isWeighted() ? edge->getWeight() : 1);
+    }
     else
     {
         MainWindow::instance().showMessage("Invalid weight!");
@@ -249,7 +344,7 @@ void GraphicsView::setNodeToolTip(Node *node)
                "ToolTip: ", &ok);
 
     if (ok && !tooltip.isEmpty())
-        node->setToolTip(tooltip);
+        node->setLabel(tooltip);
     else
     {
         MainWindow::instance().showMessage("Invalid tooltip!");
@@ -259,6 +354,64 @@ void GraphicsView::setNodeToolTip(Node *node)
     setMode(Default);
 }
 
+void GraphicsView::registerEdge(Edge *edge)
+{
+    QPair<Node*, Node*> vertices;
+
+    if (!edge)
+        LOG_EXIT("Invalid pointer", );
+
+    vertices = edge->getVertices();
+
+    if (!vertices.first || !vertices.second)
+        LOG_EXIT("Edge isn't connected", );
+
+    m_model.addEdge(vertices.first->index(), vertices.second->index(),
+      edge->isWeighted() ? edge->getWeight() : 1);
+    m_edge_index.insert(arcKey(vertices.first->index(),
+      vertices.second->index()), edge);
+    m_edge_index.insert(arcKey(vertices.second->index(),
+      vertices.first->index()), edge);
+}
+
+Edge *GraphicsView::findEdge(const Node *from, const Node *to) const
+{
+    if (!from || !to)
+        LOG_EXIT("Invalid pointer", nullptr);
+
+    return m_edge_index.value(arcKey(from->index(), to->index()), nullptr);
+}
+
+void GraphicsView::unindexEdge(Edge *edge)
+{
+    quint64 key;
+    QPair<Node*, Node*> vertices = edge->getVertices();
+
+    if (!vertices.first || !vertices.second)
+        return;
+
+    key = arcKey(vertices.first->index(), vertices.second->index());
+
+    if (m_edge_index.value(key, nullptr) == edge)
+        m_edge_index.remove(key);
+
+    key = arcKey(vertices.second->index(), vertices.first->index());
+
+    if (m_edge_index.value(key, nullptr) == edge)
+        m_edge_index.remove(key);
+}
+
+void GraphicsView::directEdge(Node *from, Node *to)
+{
+    m_model.setDirected(from->index(), to->index());
+    m_edge_index.remove(arcKey(to->index(), from->index()));
+}
+
+const GraphModel &GraphicsView::getModel() const
+{
+    return m_model;
+}
+
 void GraphicsView::updateMarks()
 {
     for(int i=0; i<m_nodes.size(); i++)
@@ -377,6 +530,14 @@ Node *GraphicsView::addNode(const size_t radius, const QBrush brush,
 
     rect.setRect(pos.x() - radius / 2, pos.y() - radius / 2, radius, radius);
 
+    /* XXX: Ids of a headless graph are taken, a node would collide */
+    if (isHeadless())
+    {
+        MainWindow::instance().showMessage("Graph has no layout, clear "
+          "the canvas first!");
+        LOG_EXIT("Headless graph", nullptr);
+    }
+
     if (isNodeIntersected(rect))
         LOG_EXIT("Node intersected!", nullptr);
 
@@ -386,6 +547,9 @@ Node *GraphicsView::addNode(const size_t radius, const QBrush brush,
 
     m_scene->addItem(item);
     m_nodes.push_back(item);
+    indexNode(item);
+    m_model.addNode(item->index());
+    m_model.setPosition(item->index(), rect.center());
 
     return item;
 }
@@ -458,6 +622,7 @@ void GraphicsView::deleteNode(Node *node)
             else
                 LOG_DEBUG("Can't find neighbor!");
 
+            unindexEdge(edge);
             m_scene->removeItem(edge);
             delete edge;
         }
@@ -469,12 +634,14 @@ void GraphicsView::deleteNode(Node *node)
 
         if (e->isDirectable())
         {
+            unindexEdge(e);
             m_scene->removeItem(e);
             delete e;
         }
     }
 
     m_scene->removeItem(node);
+    m_model.removeNode(node->index());
     removeNode(node);
 
     if (node == m_start_node)
@@ -496,6 +663,8 @@ void GraphicsView::deleteEdge(Edge *edge)
         LOG_EXIT("Invalid pointer", );
 
     vertices = edge->getVertices();
+    m_model.removeEdge(vertices.first->index(), vertices.second->index());
+    unindexEdge(edge);
 
     index = vertices.first->findEdge(edge);
     vertices.first->delNeighbor(vertices.second);
@@ -524,6 +693,8 @@ void GraphicsView::removeNode(Node *node)
     if (!node)
         LOG_EXIT("Invalid pointer", );
 
+    unindexNode(node);
+
     for(int i=0; i<m_nodes.size(); i++)
         if (m_nodes[i] == node)
             m_nodes.remove(i);
@@ -546,13 +717,10 @@ Node *GraphicsView::getFinishNode() const
 
 Node *GraphicsView::findNodeByIndex(int index) const
 {
-    for(int i=0; i<m_nodes.size(); i++)
-    {
-        if (m_nodes[i]->text().toInt() == (index + 1))
-            return m_nodes[i];
-    }
+    if (index < 0 || index >= m_index.size())
+        return nullptr;
 
-    return nullptr;
+    return m_index[index];
 }
 
 void GraphicsView::mousePressEvent(QMouseEvent *event)
@@ -621,6 +789,8 @@ void GraphicsView::mouseMoveEvent(QMouseEvent *event)
         edges = m_selected_node->getEdges();
         m_selected_node->setRect(pos.x() - radius / 2,
           pos.y() - radius / 2, radius, radius);
+        m_model.setPosition(m_selected_node->index(),
+          m_selected_node->rect().center());
 
         for(int i=0; i<(*edges).size(); i++)
         {
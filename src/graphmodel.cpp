@@ -0,0 +1,274 @@
+#include "graphmodel.h"
+#include "log.h"
+
+GraphModel::GraphModel()
+    : m_alive(0),
+      m_positions(0),
+      m_count(0),
+      m_version(0),
+      m_changes(0),
+      m_log_base(0)
+{
+
+}
+
+GraphModel::~GraphModel()
+{
+
+}
+
+void GraphModel::addNode(int id)
+{
+    if (id < 0)
+        LOG_EXIT("Invalid id:" << id, );
+
+    if (id >= m_alive.size())
+    {
+        m_alive.resize(id + 1);
+        m_graph.resize(id + 1);
+        m_reverse.resize(id + 1);
+        m_positions.resize(id + 1);
+    }
+
+    if (m_alive[id])
+        LOG_EXIT("Node already exists:" << id, );
+
+    m_alive[id] = true;
+    m_count++;
+    m_version++;
+    resetLog();
+}
+
+void GraphModel::removeNode(int id)
+{
+    if (!isNode(id))
+        LOG_EXIT("Invalid id:" << id, );
+
+    while (m_graph.degree(id))
+    {
+        if (!removeArc(id, m_graph.neighbors(id)[m_graph.degree(id) - 1]))
+            break;
+    }
+
+    while (m_reverse.degree(id))
+    {
+        if (!removeArc(m_reverse.neighbors(id)[m_reverse.degree(id) - 1], id))
+            break;
+    }
+
+    m_alive[id] = false;
+    m_count--;
+    m_version++;
+    resetLog();
+
+    /* XXX: Shrink tail, so capacity() follows the biggest living id */
+    while (!m_alive.isEmpty() && !m_alive.back())
+    {
+        m_alive.pop_back();
+        m_positions.pop_back();
+    }
+
+    m_graph.resize(m_alive.size());
+    m_reverse.resize(m_alive.size());
+}
+
+bool GraphModel::isNode(int id) const
+{
+    return id >= 0 && id < m_alive.size() && m_alive[id];
+}
+
+int GraphModel::capacity() const
+{
+    return m_alive.size();
+}
+
+int GraphModel::nodeCount() const
+{
+    return m_count;
+}
+
+void GraphModel::setPosition(int id, QPointF pos)
+{
+    if (!isNode(id))
+        LOG_EXIT("Invalid id:" << id, );
+
+    m_positions[id] = pos;
+    m_version++;
+}
+
+QPointF GraphModel::position(int id) const
+{
+    return isNode(id) ? m_positions[id] : QPointF();
+}
+
+const QVector<QPointF> &GraphModel::positions() const
+{
+    return m_positions;
+}
+
+bool GraphModel::addEdge(int first, int second, int weight)
+{
+    if (!isNode(first) || !isNode(second) || first == second)
+        LOG_EXIT("Invalid edge:" << first << second, false);
+
+    return addArc(first, second, weight) && addArc(second, first, weight);
+}
+
+bool GraphModel::removeEdge(int first, int second)
+{
+    bool forward = removeArc(first, second);
+    bool backward = removeArc(second, first);
+
+    return forward || backward;
+}
+
+bool GraphModel::setWeight(int first, int second, int weight)
+{
+    bool result = false;
+
+    if (!isNode(first) || !isNode(second))
+        return false;
+
+    /* XXX: Both arcs of an undirected edge, the one of a directed edge */
+    for(int i=0; i<2; i++)
+    {
+        int from = i ? second : first, to = i ? first : second;
+        int before = m_graph.weight(from, to);
+
+        if (!m_graph.setWeight(from, to, weight))
+            continue;
+
+        m_reverse.setWeight(to, from, weight);
+        logChange(from, to, before, weight);
+        result = true;
+    }
+
+    return result;
+}
+
+bool GraphModel::setDirected(int from, int to)
+{
+    if (!isNode(from) || !isNode(to) || !m_graph.contains(from, to))
+        LOG_EXIT("Invalid arc:" << from << to, false);
+
+    removeArc(to, from);
+
+    return true;
+}
+
+int GraphModel::weight(int from, int to) const
+{
+    return isNode(from) && isNode(to) ? m_graph.weight(from, to) : 0;
+}
+
+void GraphModel::clear()
+{
+    m_alive.clear();
+    m_graph.clear();
+    m_reverse.clear();
+    m_positions.clear();
+    m_count = 0;
+    m_version++;
+    resetLog();
+}
+
+void GraphModel::assign(const CSRGraph &graph)
+{
+    clear();
+
+    if (graph.isEmpty())
+        return;
+
+    m_alive.fill(true, graph.size());
+    m_graph = graph;
+    m_reverse = graph.reversed();
+    m_positions.fill(QPointF(), graph.size());
+    m_count = graph.size();
+}
+
+CSRGraph GraphModel::toCSR() const
+{
+    return m_graph;
+}
+
+const CSRGraph &GraphModel::graph() const
+{
+    return m_graph;
+}
+
+const CSRGraph &GraphModel::reverse() const
+{
+    return m_reverse;
+}
+
+quint64 GraphModel::version() const
+{
+    return m_version;
+}
+
+bool GraphModel::changesSince(quint64 version, QVector<arc_change_t> *changes)
+  const
+{
+    int first = m_changes.size();
+
+    if (!changes || version < m_log_base || version > m_version)
+        return false;
+
+    /* XXX: Log is sorted by version, take its tail */
+    while (first > 0 && m_changes[first - 1].version > version)
+        first--;
+
+    *changes = m_changes.mid(first);
+
+    return true;
+}
+
+void GraphModel::logChange(int from, int to, int before, int after)
+{
+    arc_change_t change;
+
+    m_version++;
+
+    if (m_changes.size() >= LogLimit)
+    {
+        resetLog();
+        return;
+    }
+
+    change.version = m_version;
+    change.from = from;
+    change.to = to;
+    change.before = before;
+    change.after = after;
+    m_changes.push_back(change);
+}
+
+void GraphModel::resetLog()
+{
+    m_changes.clear();
+    m_log_base = m_version;
+}
+
+bool GraphModel::addArc(int from, int to, int weight)
+{
+    if (!m_graph.insertArc(from, to, weight))
+        LOG_EXIT("Arc already exists:" << from << to, false);
+
+    m_reverse.insertArc(to, from, weight);
+    logChange(from, to, -1, weight);
+
+    return true;
+}
+
+bool GraphModel::removeArc(int from, int to)
+{
+    int before = m_graph.weight(from, to);
+
+    if (!isNode(from) || !isNode(to) || !m_graph.removeArc(from, to))
+        return false;
+
+    m_reverse.removeArc(to, from);
+    logChange(from, to, before, -1);
+
+    return true;
+}
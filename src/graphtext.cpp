@@ -0,0 +1,913 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include "graphtext.h"
+#include "log.h"
+
+/* XXX: One number of a line: 1 - got it, 0 - the line is over,
+ * -1 - not a number or out of int range */
+static inline int parseInt(const char **pos, const char *end, int *value)
+{
+    const char *p = *pos;
+    qint64 result = 0;
+    bool negative = false;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+
+    if (p == end)
+    {
+        *pos = p;
+        return 0;
+    }
+
+    if (*p == '-')
+    {
+        negative = true;
+        p++;
+    }
+
+    if (p == end || *p < '0' || *p > '9')
+        return -1;
+
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        result = result * 10 + (*p++ - '0');
+
+        if (result > INT32_MAX)
+            return -1;
+    }
+
+    /* Glued to something else, like "12abc" */
+    if (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+        return -1;
+
+    *value = (int) (negative ? -result : result);
+    *pos = p;
+
+    return 1;
+}
+
+static inline void appendInt(QByteArray &buffer, int value)
+{
+    char digits[12];
+    int count = 0;
+    unsigned int rest = value < 0 ? -(unsigned int) value : value;
+
+    do
+    {
+        digits[count++] = '0' + rest % 10;
+        rest /= 10;
+    } while (rest);
+
+    if (value < 0)
+        buffer.append('-');
+
+    while (count)
+        buffer.append(digits[--count]);
+}
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char *skipBlanks(const char *p, const char *end)
+{
+    while (p < end && isBlank(*p))
+        p++;
+
+    return p;
+}
+
+/* XXX: Case insensitive match of the next word of a line */
+static inline bool parseWord(const char **pos, const char *end,
+  const char *expected)
+{
+    const char *p = skipBlanks(*pos, end);
+    int length = strlen(expected);
+
+    if (end - p < length || (p + length < end && !isBlank(p[length])))
+        return false;
+
+    for(int i=0; i<length; i++)
+    {
+        if (tolower((unsigned char) p[i]) != expected[i])
+            return false;
+    }
+
+    *pos = p + length;
+
+    return true;
+}
+
+static inline void skipWord(const char **pos, const char *end)
+{
+    const char *p = skipBlanks(*pos, end);
+
+    while (p < end && !isBlank(*p))
+        p++;
+
+    *pos = p;
+}
+
+/* XXX: Like parseInt, for "-1.5e3" style values. Decimal point only,
+ * strtod would follow the locale the GUI sets */
+static inline int parseReal(const char **pos, const char *end, double *value)
+{
+    const char *p = skipBlanks(*pos, end);
+    double mantissa = 0;
+    int exponent = 0, scale = 0, digits = 0;
+    bool negative = false;
+
+    if (p == end)
+    {
+        *pos = p;
+        return 0;
+    }
+
+    if (*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+
+    for(; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+        mantissa = mantissa * 10 + (*p - '0');
+
+    if (p < end && *p == '.')
+    {
+        for(p++; p < end && *p >= '0' && *p <= '9'; p++, digits++, scale--)
+            mantissa = mantissa * 10 + (*p - '0');
+    }
+
+    if (!digits)
+        return -1;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        if (++p < end && *p == '+')
+            p++;
+
+        if (p == end || isBlank(*p) || parseInt(&p, end, &exponent) <= 0)
+            return -1;
+    }
+
+    if (p < end && !isBlank(*p))
+        return -1;
+
+    *value = (negative ? -mantissa : mantissa) * pow(10.0, exponent + scale);
+    *pos = p;
+
+    return 1;
+}
+
+GraphText::GraphText()
+    : m_size(0),
+      m_line(0),
+      m_error_line(0),
+      m_throughput(0),
+      m_stage(0),
+      m_declared(0),
+      m_vertex(0),
+      m_metis_format(0),
+      m_metis_ncon(0),
+      m_symmetric(false),
+      m_pattern(false)
+{
+
+}
+
+GraphText::~GraphText()
+{
+
+}
+
+void GraphText::clear()
+{
+    m_arcs.clear();
+    m_graph.clear();
+    m_size = 0;
+    m_line = 0;
+    m_error_line = 0;
+    m_throughput = 0;
+    m_stage = 0;
+    m_declared = 0;
+    m_vertex = 0;
+    m_metis_format = 0;
+    m_metis_ncon = 0;
+    m_symmetric = false;
+    m_pattern = false;
+}
+
+int GraphText::size() const
+{
+    return m_size;
+}
+
+int GraphText::arcCount() const
+{
+    return m_graph.arcCount();
+}
+
+int GraphText::errorLine() const
+{
+    return m_error_line;
+}
+
+double GraphText::throughput() const
+{
+    return m_throughput;
+}
+
+CSRGraph GraphText::graph() const
+{
+    return m_graph;
+}
+
+bool GraphText::read(QString filename, Format format)
+{
+    QFile file(filename);
+    QElapsedTimer timer;
+    qint64 bytes;
+    bool ok;
+
+    clear();
+    timer.start();
+
+    if (!file.open(QIODevice::ReadOnly))
+        LOG_EXIT("Can't open file:" << filename, false);
+
+    bytes = file.size();
+    ok = (format == Matrix) ? readMatrix(file) : readLines(file, format);
+    file.close();
+
+    if (!ok)
+    {
+        int line = m_error_line;
+
+        clear();
+        m_error_line = line;
+        LOG_EXIT("Invalid file:" << filename << "line" << line, false);
+    }
+
+    if (!m_size)
+        LOG_EXIT("No nodes in:" << filename, false);
+
+    m_throughput = bytes / (1024.0 * 1024.0) /
+      qMax(timer.nsecsElapsed() / 1e9, 1e-9);
+
+    qDebug() << "Parsed" << filename << bytes << "bytes," <<
+      m_size << "nodes," << arcCount() << "arcs," << m_throughput << "MB/s";
+
+    return true;
+}
+
+bool GraphText::readLines(QFile &file, Format format)
+{
+    QByteArray buffer;
+    qint64 carry = 0;
+
+    buffer.resize(ChunkSize);
+
+    /* XXX: Whole lines of a chunk are parsed right in the buffer, the
+     * cut one moves to the front and the next chunk goes after it */
+    while (true)
+    {
+        const char *data, *newline;
+        qint64 got, start = 0, end;
+
+        if (carry == buffer.size())
+            buffer.resize(2 * buffer.size());
+
+        got = file.read(buffer.data() + carry, buffer.size() - carry);
+
+        if (got < 0)
+            LOG_EXIT("Can't read file", false);
+
+        data = buffer.constData();
+        end = carry + got;
+
+        while ((newline = (const char*) memchr(data + start, '\n',
+                 end - start)))
+        {
+            m_line++;
+
+            if (!parseLine(data + start, newline, format))
+            {
+                m_error_line = m_line;
+                return false;
+            }
+
+            start = newline - data + 1;
+        }
+
+        /* The last line may have no newline */
+        if (!got)
+        {
+            if (start < end)
+            {
+                m_line++;
+
+                if (!parseLine(data + start, data + end, format))
+                {
+                    m_error_line = m_line;
+                    return false;
+                }
+            }
+
+            break;
+        }
+
+        carry = end - start;
+        memmove(buffer.data(), data + start, carry);
+    }
+
+    return finish(format);
+}
+
+bool GraphText::readMatrix(QFile &file)
+{
+    QVector<matrix_piece_t> pieces;
+    QVector<qint32> offsets;
+    QVector<int> neighbors, weights;
+    qint64 size = file.size();
+    const uchar *data;
+    int count, rows = 0, columns = 0, lines = 0;
+
+    if (!size)
+        return true;
+
+    if (!(data = file.map(0, size)))
+        LOG_EXIT("Can't map file", false);
+
+    /* XXX: A few pieces per core for balance, each a few MB at least, so
+     * a small file is one task. Cuts move to the next line start */
+    count = qBound(1, (int) (size / PieceSize),
+      4 * qMax(1, QThread::idealThreadCount()));
+    pieces.resize(count);
+
+    for(int i=0; i<count; i++)
+    {
+        const void *newline;
+        qint64 cut = size * i / count;
+
+        if (i && (newline = memchr(data + cut, '\n', size - cut)))
+            cut = (const uchar*) newline - data + 1;
+        else if (i)
+            cut = size;
+
+        pieces[i].begin = i ? qMax(cut, pieces[i - 1].begin) : 0;
+        pieces[i].lines = 0;
+        pieces[i].error_line = 0;
+        pieces[i].columns = 0;
+
+        if (i)
+            pieces[i - 1].end = pieces[i].begin;
+    }
+
+    pieces.back().end = size;
+
+    QtConcurrent::blockingMap(pieces, [data](matrix_piece_t &piece)
+    {
+        parseMatrix(data, piece);
+    });
+
+    file.unmap((uchar*) data);
+
+    for(int i=0; i<pieces.size(); i++)
+    {
+        if (pieces[i].error_line)
+        {
+            m_error_line = lines + pieces[i].error_line;
+            return false;
+        }
+
+        lines += pieces[i].lines;
+        rows += pieces[i].degrees.size();
+        columns = qMax(columns, pieces[i].columns);
+    }
+
+    /* XXX: Square or it isn't the matrix of a graph */
+    if (columns > rows)
+        LOG_EXIT("Not a square matrix:" << rows << columns, false);
+
+    if (!rows)
+        return true;
+
+    /* XXX: Rows come in order and columns grow within a row, so the pieces
+     * are already CSR, only glued one after another */
+    offsets.reserve(rows + 1);
+    offsets.push_back(0);
+
+    for(int i=0; i<pieces.size(); i++)
+    {
+        for(int r=0; r<pieces[i].degrees.size(); r++)
+            offsets.push_back(offsets.back() + pieces[i].degrees[r]);
+
+        neighbors += pieces[i].neighbors;
+        weights += pieces[i].weights;
+        pieces[i].neighbors.clear();
+        pieces[i].weights.clear();
+    }
+
+    m_graph.assign(rows, offsets.constData(), neighbors.constData(),
+      weights.constData());
+    m_size = rows;
+
+    return true;
+}
+
+void GraphText::parseMatrix(const uchar *data, matrix_piece_t &piece)
+{
+    const char *p = (const char*) data + piece.begin;
+    const char *end = (const char*) data + piece.end;
+    quint64 zeros;
+
+    /* XXX: The writer puts "0 0 0 0 " runs between sparse arcs, eight
+     * bytes of them are skipped by one compare. Native order either way,
+     * the pattern is loaded the same way as the text */
+    memcpy(&zeros, "0 0 0 0 ", sizeof(zeros));
+
+    while (p < end)
+    {
+        const char *eol = (const char*) memchr(p, '\n', end - p);
+        int column = 0, degree = 0;
+
+        if (!eol)
+            eol = end;
+
+        piece.lines++;
+
+        while (true)
+        {
+            int value;
+            quint64 word;
+
+            while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r'))
+                p++;
+
+            if (p == eol)
+                break;
+
+            if (eol - p >= 8 && (memcpy(&word, p, sizeof(word)),
+                 word == zeros))
+            {
+                p += 8;
+                column += 4;
+                continue;
+            }
+
+            if (*p == '0' && (p + 1 == eol || p[1] == ' ' ||
+                 p[1] == '\t' || p[1] == '\r'))
+            {
+                p++;
+                column++;
+                continue;
+            }
+
+            if (parseInt(&p, eol, &value) <= 0 || value < 0)
+            {
+                piece.error_line = piece.lines;
+                return;
+            }
+
+            if (value)
+            {
+                piece.neighbors.push_back(column);
+                piece.weights.push_back(value);
+                degree++;
+            }
+
+            column++;
+        }
+
+        /* Blank line, not a row */
+        if (column)
+        {
+            piece.degrees.push_back(degree);
+            piece.columns = qMax(piece.columns, column);
+        }
+
+        p = (eol < end) ? eol + 1 : end;
+    }
+}
+
+bool GraphText::parseLine(const char *begin, const char *end, Format format)
+{
+    switch(format)
+    {
+        case EdgeList:
+        return parseArc(begin, end);
+
+        case Dimacs:
+        return parseDimacs(begin, end);
+
+        case Metis:
+        return parseMetis(begin, end);
+
+        case MatrixMarket:
+        return parseMarket(begin, end);
+
+        case Snap:
+        return parseSnap(begin, end);
+
+        default:
+        return false;
+    }
+}
+
+bool GraphText::parseArc(const char *begin, const char *end)
+{
+    arc_t arc;
+    const char *p = begin;
+    int status;
+
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+
+    if (p == end || *p == '#' || *p == '%')
+        return true;
+
+    if (parseInt(&p, end, &arc.from) <= 0 || parseInt(&p, end, &arc.to) <= 0)
+        return false;
+
+    if ((status = parseInt(&p, end, &arc.weight)) < 0)
+        return false;
+
+    if (!status)
+        arc.weight = 1;
+    else if (parseInt(&p, end, &status) != 0)
+        return false;
+
+    if (arc.from < 1 || arc.to < 1 || arc.weight < 0)
+        return false;
+
+    /* XXX: Names are shown from 1, ids start from 0 */
+    m_size = qMax(m_size, qMax(arc.from, arc.to));
+    arc.from--;
+    arc.to--;
+    m_arcs.push_back(arc);
+
+    return true;
+}
+
+bool GraphText::parseDimacs(const char *begin, const char *end)
+{
+    arc_t arc;
+    const char *p = skipBlanks(begin, end);
+    int arcs;
+
+    if (p == end || *p == 'c')
+        return true;
+
+    /* XXX: "p sp n m", the problem name isn't checked */
+    if (parseWord(&p, end, "p"))
+    {
+        if (m_stage)
+            return false;
+
+        skipWord(&p, end);
+
+        if (parseInt(&p, end, &m_declared) <= 0 ||
+             parseInt(&p, end, &arcs) <= 0 || parseInt(&p, end, &arcs) != 0 ||
+             m_declared <= 0)
+        {
+            return false;
+        }
+
+        m_size = m_declared;
+        m_stage = 1;
+
+        return true;
+    }
+
+    if (!m_stage || !parseWord(&p, end, "a"))
+        return false;
+
+    if (parseInt(&p, end, &arc.from) <= 0 || parseInt(&p, end, &arc.to) <= 0 ||
+         parseInt(&p, end, &arc.weight) <= 0 || parseInt(&p, end, &arcs) != 0)
+    {
+        return false;
+    }
+
+    if (arc.from < 1 || arc.from > m_declared || arc.to < 1 ||
+         arc.to > m_declared || arc.weight < 0)
+    {
+        return false;
+    }
+
+    if (arc.from != arc.to)
+    {
+        arc.from--;
+        arc.to--;
+        m_arcs.push_back(arc);
+    }
+
+    return true;
+}
+
+bool GraphText::parseMetis(const char *begin, const char *end)
+{
+    arc_t arc;
+    const char *p = skipBlanks(begin, end);
+    int value, status;
+
+    if (p < end && *p == '%')
+        return true;
+
+    /* XXX: fmt is three flags written as digits: vertex sizes, vertex
+     * weights, edge weights */
+    if (!m_stage)
+    {
+        if (p == end)
+            return true;
+
+        if (parseInt(&p, end, &m_declared) <= 0 ||
+             parseInt(&p, end, &value) <= 0 || m_declared <= 0)
+        {
+            return false;
+        }
+
+        if ((status = parseInt(&p, end, &m_metis_format)) < 0 ||
+             (status && m_metis_format % 10 > 1) ||
+             (status && m_metis_format / 10 % 10 > 1) ||
+             (status && m_metis_format / 100 > 1))
+        {
+            return false;
+        }
+
+        if ((status = parseInt(&p, end, &m_metis_ncon)) < 0 ||
+             (status && m_metis_ncon <= 0) || parseInt(&p, end, &value) != 0)
+        {
+            return false;
+        }
+
+        if (!status)
+            m_metis_ncon = 1;
+
+        m_size = m_declared;
+        m_stage = 1;
+
+        return true;
+    }
+
+    /* XXX: A blank line is a node without neighbours, only trailing
+     * ones past the last node are let go */
+    if (m_vertex == m_declared)
+        return p == end;
+
+    arc.from = m_vertex++;
+
+    if (m_metis_format / 100 && parseInt(&p, end, &value) <= 0)
+        return false;
+
+    for(int c=0; m_metis_format / 10 % 10 && c<m_metis_ncon; c++)
+    {
+        if (parseInt(&p, end, &value) <= 0)
+            return false;
+    }
+
+    while ((status = parseInt(&p, end, &arc.to)) > 0)
+    {
+        arc.weight = 1;
+
+        if (m_metis_format % 10 && parseInt(&p, end, &arc.weight) <= 0)
+            return false;
+
+        if (arc.to < 1 || arc.to > m_declared || arc.weight < 0)
+            return false;
+
+        if (--arc.to != arc.from)
+            m_arcs.push_back(arc);
+    }
+
+    return status == 0;
+}
+
+bool GraphText::parseMarket(const char *begin, const char *end)
+{
+    arc_t arc;
+    const char *p = begin;
+    int rows, columns, entries;
+    double value = 1;
+
+    if (!m_stage)
+    {
+        if (!parseWord(&p, end, "%%matrixmarket") ||
+             !parseWord(&p, end, "matrix") ||
+             !parseWord(&p, end, "coordinate"))
+        {
+            return false;
+        }
+
+        if (parseWord(&p, end, "pattern"))
+            m_pattern = true;
+        else if (!parseWord(&p, end, "real") && !parseWord(&p, end, "integer"))
+            return false;
+
+        if (parseWord(&p, end, "symmetric"))
+            m_symmetric = true;
+        else if (!parseWord(&p, end, "general"))
+            return false;
+
+        m_stage = 1;
+
+        return skipBlanks(p, end) == end;
+    }
+
+    p = skipBlanks(p, end);
+
+    if (p == end || *p == '%')
+        return true;
+
+    if (m_stage == 1)
+    {
+        if (parseInt(&p, end, &rows) <= 0 || parseInt(&p, end, &columns) <= 0 ||
+             parseInt(&p, end, &entries) <= 0 ||
+             parseInt(&p, end, &entries) != 0 || rows <= 0 || columns <= 0)
+        {
+            return false;
+        }
+
+        /* XXX: A graph is square, a rectangular matrix gets spare nodes */
+        m_size = m_declared = qMax(rows, columns);
+        m_stage = 2;
+
+        return true;
+    }
+
+    if (parseInt(&p, end, &arc.from) <= 0 || parseInt(&p, end, &arc.to) <= 0)
+        return false;
+
+    if (!m_pattern && parseReal(&p, end, &value) <= 0)
+        return false;
+
+    if (parseReal(&p, end, &value) != 0 || value < 0 || value > INT32_MAX ||
+         arc.from < 1 || arc.from > m_declared || arc.to < 1 ||
+         arc.to > m_declared)
+    {
+        return false;
+    }
+
+    if (arc.from == arc.to)
+        return true;
+
+    arc.from--;
+    arc.to--;
+    arc.weight = qRound(value);
+    m_arcs.push_back(arc);
+
+    if (m_symmetric)
+    {
+        qSwap(arc.from, arc.to);
+        m_arcs.push_back(arc);
+    }
+
+    return true;
+}
+
+bool GraphText::parseSnap(const char *begin, const char *end)
+{
+    arc_t arc;
+    const char *p = skipBlanks(begin, end);
+    int status;
+
+    if (p == end || *p == '#')
+        return true;
+
+    if (parseInt(&p, end, &arc.from) <= 0 || parseInt(&p, end, &arc.to) <= 0)
+        return false;
+
+    if ((status = parseInt(&p, end, &arc.weight)) < 0)
+        return false;
+
+    if (!status)
+        arc.weight = 1;
+    else if (parseInt(&p, end, &status) != 0)
+        return false;
+
+    if (arc.from < 0 || arc.to < 0 || arc.weight < 0 ||
+         arc.from == INT32_MAX || arc.to == INT32_MAX)
+    {
+        return false;
+    }
+
+    if (arc.from != arc.to)
+    {
+        m_size = qMax(m_size, qMax(arc.from, arc.to) + 1);
+        m_arcs.push_back(arc);
+    }
+
+    return true;
+}
+
+bool GraphText::finish(Format format)
+{
+    /* XXX: Line 1 is where the missing header should have been */
+    if ((format == Dimacs || format == Metis) && !m_stage)
+    {
+        m_error_line = 1;
+        return false;
+    }
+
+    if (format == MatrixMarket && m_stage != 2)
+    {
+        m_error_line = m_line ? m_line : 1;
+        return false;
+    }
+
+    /* XXX: Social graphs number nodes with holes, ids are packed so the
+     * graph isn't mostly nodes nobody links to */
+    if (format == Snap && m_size)
+    {
+        QVector<int> ids;
+
+        ids.reserve(2 * m_arcs.size());
+
+        for(int i=0; i<m_arcs.size(); i++)
+        {
+            ids.push_back(m_arcs[i].from);
+            ids.push_back(m_arcs[i].to);
+        }
+
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        if (ids.size() < m_size)
+        {
+            for(int i=0; i<m_arcs.size(); i++)
+            {
+                m_arcs[i].from = std::lower_bound(ids.begin(), ids.end(),
+                  m_arcs[i].from) - ids.begin();
+                m_arcs[i].to = std::lower_bound(ids.begin(), ids.end(),
+                  m_arcs[i].to) - ids.begin();
+            }
+
+            m_size = ids.size();
+        }
+    }
+
+    if (m_size)
+        m_graph.build(m_size, m_arcs);
+
+    m_arcs.clear();
+
+    return true;
+}
+
+bool GraphText::writeEdgeList(QString filename, const CSRGraph &graph)
+{
+    QFile file(filename);
+    QByteArray buffer;
+
+    if (graph.isEmpty())
+        LOG_EXIT("Graph is empty", false);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        LOG_EXIT("Can't open file:" << filename, false);
+
+    buffer.reserve(ChunkSize + 64);
+
+    for(int i=0; i<graph.size(); i++)
+    {
+        const int *adj = graph.neighbors(i);
+        const int *weights = graph.weights(i);
+
+        for(int k=0; k<graph.degree(i); k++)
+        {
+            appendInt(buffer, i + 1);
+            buffer.append(' ');
+            appendInt(buffer, adj[k] + 1);
+            buffer.append(' ');
+            appendInt(buffer, weights[k]);
+            buffer.append('\n');
+
+            if (buffer.size() >= ChunkSize)
+            {
+                if (file.write(buffer) != buffer.size())
+                {
+                    file.close();
+                    file.remove();
+                    LOG_EXIT("Can't write file:" << filename, false);
+                }
+
+                /* Keeps the reserved capacity, unlike clear() */
+                buffer.resize(0);
+            }
+        }
+    }
+
+    if (file.write(buffer) != buffer.size())
+    {
+        file.close();
+        file.remove();
+        LOG_EXIT("Can't write file:" << filename, false);
+    }
+
+    file.close();
+
+    return true;
+}
@@ -0,0 +1,338 @@
+#include <QtAlgorithms>
+
+#include "heap.h"
+#include "log.h"
+
+BinaryHeap::BinaryHeap(int capacity)
+    : m_items(0)
+{
+    m_items.reserve(capacity);
+}
+
+void BinaryHeap::push(int key, int value)
+{
+    int i = m_items.size();
+    heap_item_t item;
+
+    item.key = key;
+    item.value = value;
+    m_items.push_back(item);
+
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+
+        if (m_items[parent].key <= key)
+            break;
+
+        m_items[i] = m_items[parent];
+        i = parent;
+    }
+
+    m_items[i] = item;
+}
+
+bool BinaryHeap::pop(int *key, int *value)
+{
+    int i = 0, size;
+    heap_item_t last;
+
+    if (m_items.isEmpty())
+        return false;
+
+    *key = m_items[0].key;
+    *value = m_items[0].value;
+
+    last = m_items.back();
+    m_items.pop_back();
+    size = m_items.size();
+
+    if (!size)
+        return true;
+
+    while (true)
+    {
+        int child = 2 * i + 1;
+
+        if (child >= size)
+            break;
+
+        if (child + 1 < size && m_items[child + 1].key < m_items[child].key)
+            child++;
+
+        if (last.key <= m_items[child].key)
+            break;
+
+        m_items[i] = m_items[child];
+        i = child;
+    }
+
+    m_items[i] = last;
+
+    return true;
+}
+
+void BinaryHeap::reserve(int capacity)
+{
+    m_items.reserve(capacity);
+}
+
+bool BinaryHeap::isEmpty() const
+{
+    return m_items.isEmpty();
+}
+
+int BinaryHeap::size() const
+{
+    return m_items.size();
+}
+
+void BinaryHeap::clear()
+{
+    m_items.clear();
+}
+
+PairingHeap::PairingHeap(int capacity)
+    : m_key(capacity, 0),
+      m_child(capacity, -1),
+      m_sibling(capacity, -1),
+      m_prev(capacity, -1),
+      m_in_heap(capacity, false),
+      m_pairs(0),
+      m_root(-1),
+      m_size(0)
+{
+
+}
+
+int PairingHeap::meld(int first, int second)
+{
+    if (first == -1)
+        return second;
+
+    if (second == -1)
+        return first;
+
+    if (m_key[second] < m_key[first])
+        qSwap(first, second);
+
+    /* second becomes the leftmost child of first */
+    m_sibling[second] = m_child[first];
+
+    if (m_child[first] != -1)
+        m_prev[m_child[first]] = second;
+
+    m_prev[second] = first;
+    m_child[first] = second;
+
+    return first;
+}
+
+void PairingHeap::cut(int node)
+{
+    int prev = m_prev[node];
+
+    if (prev == -1)
+        return;
+
+    if (m_child[prev] == node)
+        m_child[prev] = m_sibling[node];
+    else
+        m_sibling[prev] = m_sibling[node];
+
+    if (m_sibling[node] != -1)
+        m_prev[m_sibling[node]] = prev;
+
+    m_sibling[node] = -1;
+    m_prev[node] = -1;
+}
+
+void PairingHeap::push(int key, int value)
+{
+    if (value < 0 || value >= m_key.size())
+        LOG_EXIT("Invalid value:" << value, );
+
+    if (m_in_heap[value])
+    {
+        if (key >= m_key[value])
+            return;
+
+        m_key[value] = key;
+
+        if (value != m_root)
+        {
+            cut(value);
+            m_root = meld(m_root, value);
+        }
+
+        return;
+    }
+
+    m_key[value] = key;
+    m_child[value] = m_sibling[value] = m_prev[value] = -1;
+    m_in_heap[value] = true;
+    m_root = meld(m_root, value);
+    m_size++;
+}
+
+bool PairingHeap::pop(int *key, int *value)
+{
+    int child, result = -1;
+
+    if (m_root == -1)
+        return false;
+
+    *key = m_key[m_root];
+    *value = m_root;
+    m_in_heap[m_root] = false;
+    m_size--;
+
+    m_pairs.clear();
+
+    for(child = m_child[m_root]; child != -1; )
+    {
+        int next = m_sibling[child];
+
+        m_sibling[child] = m_prev[child] = -1;
+        m_pairs.push_back(child);
+        child = next;
+    }
+
+    m_child[m_root] = -1;
+
+    /* XXX: Two-pass pairing: meld neighbours left to right,
+     * then fold the results right to left */
+    for(int i=0; i + 1<m_pairs.size(); i += 2)
+        m_pairs[i / 2] = meld(m_pairs[i], m_pairs[i + 1]);
+
+    if (m_pairs.size() % 2)
+        m_pairs[m_pairs.size() / 2] = m_pairs.back();
+
+    for(int i=(m_pairs.size() + 1) / 2 - 1; i>=0; i--)
+        result = meld(m_pairs[i], result);
+
+    m_root = result;
+
+    return true;
+}
+
+void PairingHeap::reserve(int capacity)
+{
+    if (capacity <= m_key.size())
+        return;
+
+    /* XXX: New handles are out of the heap, push() sets up the links */
+    m_key.resize(capacity);
+    m_child.resize(capacity);
+    m_sibling.resize(capacity);
+    m_prev.resize(capacity);
+    m_in_heap.resize(capacity);
+}
+
+bool PairingHeap::isEmpty() const
+{
+    return m_root == -1;
+}
+
+int PairingHeap::size() const
+{
+    return m_size;
+}
+
+void PairingHeap::clear()
+{
+    while (m_root != -1)
+    {
+        int key, value;
+
+        pop(&key, &value);
+    }
+}
+
+RadixHeap::RadixHeap(int capacity)
+    : m_last(0),
+      m_size(0)
+{
+    m_buckets[0].reserve(capacity);
+}
+
+int RadixHeap::bucket(int key) const
+{
+    if (key == m_last)
+        return 0;
+
+    return 32 - qCountLeadingZeroBits((quint32) (key ^ m_last));
+}
+
+void RadixHeap::push(int key, int value)
+{
+    heap_item_t item;
+
+    if (key < m_last)
+        LOG_EXIT("Key is less than the last popped one:" << key, );
+
+    item.key = key;
+    item.value = value;
+    m_buckets[bucket(key)].push_back(item);
+    m_size++;
+}
+
+bool RadixHeap::pop(int *key, int *value)
+{
+    if (!m_size)
+        return false;
+
+    if (m_buckets[0].isEmpty())
+    {
+        int i = 1;
+        QVector<heap_item_t> items;
+
+        while (m_buckets[i].isEmpty())
+            i++;
+
+        m_last = m_buckets[i][0].key;
+
+        for(int j=1; j<m_buckets[i].size(); j++)
+            m_last = qMin(m_last, m_buckets[i][j].key);
+
+        /* XXX: Every item of the bucket moves to a lower one */
+        items.swap(m_buckets[i]);
+
+        for(int j=0; j<items.size(); j++)
+            m_buckets[bucket(items[j].key)].push_back(items[j]);
+
+        items.clear();
+        m_buckets[i].swap(items);
+    }
+
+    *key = m_buckets[0].back().key;
+    *value = m_buckets[0].back().value;
+    m_buckets[0].pop_back();
+    m_size--;
+
+    return true;
+}
+
+void RadixHeap::reserve(int capacity)
+{
+    m_buckets[0].reserve(capacity);
+}
+
+bool RadixHeap::isEmpty() const
+{
+    return !m_size;
+}
+
+int RadixHeap::size() const
+{
+    return m_size;
+}
+
+void RadixHeap::clear()
+{
+    for(int i=0; i<Buckets; i++)
+        m_buckets[i].clear();
+
+    m_last = 0;
+    m_size = 0;
+}
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstring>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include "landmarks.h"
+#include "log.h"
+
+Landmarks::Landmarks()
+    : m_size(0),
+      m_count(0),
+      m_selection(Farthest),
+      m_fingerprint(0)
+{
+
+}
+
+Landmarks::~Landmarks()
+{
+
+}
+
+void Landmarks::clear()
+{
+    m_landmarks.clear();
+    m_forward.clear();
+    m_backward.clear();
+    m_size = 0;
+    m_count = 0;
+    m_fingerprint = 0;
+}
+
+bool Landmarks::isEmpty() const
+{
+    return !m_count;
+}
+
+int Landmarks::size() const
+{
+    return m_size;
+}
+
+int Landmarks::count() const
+{
+    return m_count;
+}
+
+Landmarks::Selection Landmarks::selection() const
+{
+    return m_selection;
+}
+
+int Landmarks::landmark(int i) const
+{
+    return m_landmarks[i];
+}
+
+void Landmarks::distances(const CSRGraph &graph, int source,
+  QVector<qint32> *result, BinaryHeap &heap)
+{
+    result->fill(INF, graph.size());
+    heap.clear();
+    heap.reserve(graph.size());
+
+    (*result)[source] = 0;
+    heap.push(0, source);
+
+    while(!heap.isEmpty())
+    {
+        int key, current;
+        const int *adj, *weights;
+
+        heap.pop(&key, &current);
+
+        /* Stale entry, node was reached by a shorter way already */
+        if (key > (*result)[current])
+            continue;
+
+        adj = graph.neighbors(current);
+        weights = graph.weights(current);
+
+        for(int k=0; k<graph.degree(current); k++)
+        {
+            if (key + weights[k] < (*result)[adj[k]])
+            {
+                (*result)[adj[k]] = key + weights[k];
+                heap.push(key + weights[k], adj[k]);
+            }
+        }
+    }
+}
+
+bool Landmarks::selectFarthest(const CSRGraph &graph, int count,
+  std::function<bool(int)> stop)
+{
+    QVector<qint32> nearest(graph.size(), INF), row;
+    BinaryHeap heap;
+    int next = 0;
+
+    /* XXX: The first one is the farthest from node 0, not node 0 itself,
+     * so it lies on the rim too. Not reached counts as farthest, that
+     * way other components get their landmarks */
+    distances(graph, 0, &row, heap);
+
+    for(int l=0; l<count; l++)
+    {
+        int far = -1;
+
+        if (stop && stop(graph.size()))
+            return false;
+
+        for(int i=0; i<graph.size(); i++)
+        {
+            if (row[i] > far && nearest[i] != 0)
+            {
+                far = row[i];
+                next = i;
+            }
+        }
+
+        m_landmarks.push_back(next);
+        distances(graph, next, &row, heap);
+
+        for(int i=0; i<graph.size(); i++)
+            nearest[i] = qMin(nearest[i], row[i]);
+
+        /* XXX: From now on the distance to the nearest landmark decides */
+        row = nearest;
+    }
+
+    return true;
+}
+
+void Landmarks::selectDegree(const CSRGraph &graph, const CSRGraph &reverse,
+  int count)
+{
+    QVector<int> nodes(graph.size());
+
+    for(int i=0; i<graph.size(); i++)
+        nodes[i] = i;
+
+    std::stable_sort(nodes.begin(), nodes.end(), [&](int a, int b)
+    {
+        return graph.degree(a) + reverse.degree(a) >
+          graph.degree(b) + reverse.degree(b);
+    });
+
+    for(int l=0; l<count; l++)
+        m_landmarks.push_back(nodes[l]);
+}
+
+bool Landmarks::build(const CSRGraph &graph, int count, Selection selection,
+  std::function<bool(int)> stop)
+{
+    CSRGraph reverse = graph.reversed();
+    QVector<landmark_task_t> tasks;
+
+    clear();
+
+    if (graph.isEmpty() || count <= 0)
+        LOG_EXIT("Invalid parameter:" << graph.size() << count, false);
+
+    count = qMin(qMin(count, (int) MaxCount), graph.size());
+
+    if (selection == Degree)
+        selectDegree(graph, reverse, count);
+    else if (!selectFarthest(graph, count, stop))
+    {
+        clear();
+        return false;
+    }
+
+    /* XXX: Columns are independent, every one is a task of its own */
+    tasks.resize(2 * count);
+
+    for(int t=0; t<tasks.size(); t++)
+    {
+        tasks[t].landmark = m_landmarks[t / 2];
+        tasks[t].backward = t % 2;
+    }
+
+    if (stop && stop(2 * count * graph.size()))
+    {
+        clear();
+        return false;
+    }
+
+    QtConcurrent::blockingMap(tasks, [&](landmark_task_t &task)
+    {
+        distances(task.backward ? reverse : graph, task.landmark,
+          &task.distances, task.heap);
+    });
+
+    m_size = graph.size();
+    m_count = count;
+    m_selection = selection;
+    m_fingerprint = graph.fingerprint();
+    m_forward.resize(m_size * m_count);
+    m_backward.resize(m_size * m_count);
+
+    for(int t=0; t<tasks.size(); t++)
+    {
+        QVector<qint32> &table = tasks[t].backward ? m_backward : m_forward;
+
+        for(int i=0; i<m_size; i++)
+            table[i * m_count + t / 2] = tasks[t].distances[i];
+    }
+
+    return true;
+}
+
+bool Landmarks::save(QIODevice *device) const
+{
+    landmark_header_t header;
+    QVector<qint32> ids;
+    qint64 table = (qint64) m_forward.size() * sizeof(qint32);
+
+    if (isEmpty())
+        LOG_EXIT("No landmarks", false);
+
+    for(int l=0; l<m_count; l++)
+        ids.push_back(m_landmarks[l]);
+
+    memcpy(header.magic, LANDMARK_MAGIC, sizeof(header.magic));
+    header.version = LANDMARK_VERSION;
+    header.size = m_size;
+    header.count = m_count;
+    header.selection = m_selection;
+    header.reserved = 0;
+    header.fingerprint = m_fingerprint;
+
+    if (device->write((const char*) &header, sizeof(header)) !=
+           sizeof(header) ||
+         device->write((const char*) ids.constData(),
+           ids.size() * sizeof(qint32)) !=
+           (qint64) (ids.size() * sizeof(qint32)) ||
+         device->write((const char*) m_forward.constData(), table) != table ||
+         device->write((const char*) m_backward.constData(), table) != table)
+    {
+        LOG_EXIT("Can't write landmarks", false);
+    }
+
+    return true;
+}
+
+bool Landmarks::load(QIODevice *device, const CSRGraph &graph)
+{
+    landmark_header_t header;
+    QVector<qint32> ids;
+    qint64 table;
+
+    clear();
+
+    if (device->read((char*) &header, sizeof(header)) != sizeof(header) ||
+         memcmp(header.magic, LANDMARK_MAGIC, sizeof(header.magic)) ||
+         header.version != LANDMARK_VERSION || header.count <= 0 ||
+         header.count > MaxCount || header.count > header.size ||
+         (header.selection != Farthest && header.selection != Degree))
+    {
+        LOG_EXIT("Invalid landmarks data", false);
+    }
+
+    if (header.size != graph.size() ||
+         header.fingerprint != graph.fingerprint())
+    {
+        LOG_EXIT("Landmarks of another graph", false);
+    }
+
+    ids.resize(header.count);
+    m_forward.resize(header.size * header.count);
+    m_backward.resize(header.size * header.count);
+    table = (qint64) m_forward.size() * sizeof(qint32);
+
+    if (device->read((char*) ids.data(), ids.size() * sizeof(qint32)) !=
+           (qint64) (ids.size() * sizeof(qint32)) ||
+         device->read((char*) m_forward.data(), table) != table ||
+         device->read((char*) m_backward.data(), table) != table)
+    {
+        clear();
+        LOG_EXIT("Truncated landmarks data", false);
+    }
+
+    for(int l=0; l<ids.size(); l++)
+    {
+        if (ids[l] < 0 || ids[l] >= header.size)
+        {
+            clear();
+            LOG_EXIT("Invalid landmark in data", false);
+        }
+
+        m_landmarks.push_back(ids[l]);
+    }
+
+    m_size = header.size;
+    m_count = header.count;
+    m_selection = (Selection) header.selection;
+    m_fingerprint = header.fingerprint;
+
+    return true;
+}
@@ -2,6 +2,8 @@
 #include "bfsalgorithm.h"
 #include "dfsalgorithm.h"
 #include "dejikstralgorithm.h"
+#include "astaralgorithm.h"
+#include "batchalgorithm.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : AbstractWindow(parent),
@@ -9,7 +11,10 @@ MainWindow::MainWindow(QWidget *parent)
       m_view(nullptr),
       m_settings(nullptr),
       m_algorithm(nullptr),
-      m_raport(nullptr)
+      m_algorithms(AlgorithmCount, nullptr),
+      m_batch(nullptr),
+      m_raport(nullptr),
+      m_progress(nullptr)
 {
     layout();
     setBackgroundColor();
@@ -19,8 +24,10 @@ MainWindow::~MainWindow()
 {
     m_settings->deleteLater();
 
-    if (m_algorithm)
-        delete m_algorithm;
+    for(int i=0; i<m_algorithms.size(); i++)
+        delete m_algorithms[i];
+
+    delete m_batch;
 
     if (m_raport)
         delete m_raport;
@@ -39,6 +46,54 @@ void MainWindow::showMessage(QString msg)
     QMessageBox::information(this, "Info", msg, QMessageBox::Ok);
 }
 
+void MainWindow::showProgress(AbstractAlgorithm *algorithm)
+{
+    if (!algorithm)
+        LOG_EXIT("Invalid pointer", );
+
+    if (!m_progress)
+    {
+        m_progress = new QProgressDialog("Searching...", "Cancel", 0, 0, this);
+        m_progress->setWindowModality(Qt::WindowModal);
+        m_progress->setMinimumDuration(500);
+        m_progress->setAutoReset(false);
+        /* XXX: Dialog arms its show timer in constructor */
+        m_progress->reset();
+    }
+
+    /* XXX: Only the running algorithm may be cancelled */
+    disconnect(m_progress, SIGNAL(canceled()), 0, 0);
+    connect(m_progress, SIGNAL(canceled()), algorithm, SLOT(cancel()));
+    connect(algorithm, SIGNAL(progress(int,int)), this,
+      SLOT(updateProgress(int,int)), Qt::UniqueConnection);
+    connect(algorithm, SIGNAL(stopped()), this, SLOT(hideProgress()),
+      Qt::UniqueConnection);
+
+    m_progress->setValue(0);
+}
+
+void MainWindow::updateProgress(int value, int maximum)
+{
+    if (!m_progress)
+        LOG_EXIT("Invalid pointer", );
+
+    /* XXX: Queued before the sender was disconnected */
+    if (sender() != m_algorithm)
+        return;
+
+    m_progress->setMaximum(maximum);
+    m_progress->setValue(value);
+}
+
+void MainWindow::hideProgress()
+{
+    if (sender() != m_algorithm)
+        return;
+
+    if (m_progress)
+        m_progress->reset();
+}
+
 QString MainWindow::openInputDialog(QString title, QString msg, bool *ok)
 {
     return QInputDialog::getText(this, title, msg, QLineEdit::Normal, QString(),
@@ -137,38 +192,101 @@ void MainWindow::setBackgroundColor()
     this->setStyleSheet("background: rgb(75, 75, 75);");
 }
 
-AbstractAlgorithm *MainWindow::createAlgorithm(QObject *parent)
+AbstractAlgorithm *MainWindow::getAlgorithm(int id)
 {
-    int id;
+    if (id < 0 || id >= m_algorithms.size())
+        LOG_EXIT("Invalid algorithm:" << id, nullptr);
 
-    if (m_algorithm)
+    /* XXX: Algorithms are created once and keep their buffers, so another
+     * run on the same graph allocates nothing */
+    if (!m_algorithms[id])
     {
-        delete m_algorithm;
-        m_algorithm = nullptr;
+        switch(id)
+        {
+            case BFS:
+            m_algorithms[id] = new BFSAlgorithm(this);
+            break;
+
+            case DFS:
+            m_algorithms[id] = new DFSAlgorithm(this);
+            break;
+
+            case Dejikstra:
+            m_algorithms[id] = new DejikstraAlgorithm(this);
+            break;
+
+            case AStar:
+            m_algorithms[id] = new AStarAlgorithm(this);
+            break;
+
+            default:
+            LOG_EXIT("Invalid algorithm:" << id, nullptr);
+        }
     }
 
-    switch((id = m_settings ? m_settings->selectedAlgorithm() : BFS))
+    return m_algorithms[id];
+}
+
+AbstractAlgorithm *MainWindow::createAlgorithm()
+{
+    int id = m_settings ? m_settings->selectedAlgorithm() : BFS;
+    AbstractAlgorithm *algorithm;
+
+    if (!(algorithm = getAlgorithm(id)))
+        LOG_EXIT("Invalid algorithm:" << id, nullptr);
+
+    switchAlgorithm(algorithm);
+
+    disconnect(this, SIGNAL(execute()), 0, 0);
+    connect(this, SIGNAL(execute()), m_algorithm, SLOT(run()));
+
+    emit execute();
+
+    return m_algorithm;
+}
+
+void MainWindow::runBatch(QString queries)
+{
+    QVector<batch_query_t> parsed;
+
+    if (!BatchAlgorithm::parseQueries(queries, &parsed))
     {
-        case BFS:
-        m_algorithm = new BFSAlgorithm(parent);
-        break;
+        showMessage("Invalid queries!");
+        LOG_EXIT("Invalid queries", );
+    }
 
-        case DFS:
-        m_algorithm = new DFSAlgorithm(parent);
-        break;
+    if (!m_batch)
+        m_batch = new BatchAlgorithm(this);
+
+    /* XXX: The worker reads the queries, they can't change under it */
+    if (m_batch->isRunning())
+    {
+        showMessage("Batch is still running!");
+        LOG_EXIT("Already running", );
+    }
 
-        case Dejikstra:
-        m_algorithm = new DejikstraAlgorithm(parent);
-        break;
+    switchAlgorithm(m_batch);
 
-        default:
-        LOG_DEBUG("Invalid algorithm:" << id);
-        return nullptr;
+    if (m_batch->setQueries(parsed))
+        m_batch->run();
+}
 
+void MainWindow::switchAlgorithm(AbstractAlgorithm *algorithm)
+{
+    /* XXX: The old one may still be winding down, its late signals must
+     * not touch the progress of the new run */
+    if (m_algorithm && m_algorithm != algorithm)
+    {
+        m_algorithm->cancel();
+        disconnect(m_algorithm, SIGNAL(progress(int,int)), this, 0);
+        disconnect(m_algorithm, SIGNAL(stopped()), this, 0);
     }
 
-    emit execute();
+    m_algorithm = algorithm;
+}
 
+AbstractAlgorithm *MainWindow::currentAlgorithm() const
+{
     return m_algorithm;
 }
 
@@ -200,7 +318,7 @@ void MainWindow::handleControlEvent()
     if (action->text() == "play")
     {
         restoreItems();
-        createAlgorithm(this);
+        createAlgorithm();
     }
 
     if (action->text() == "restore")
@@ -5,7 +5,8 @@ Node::Node(const QRectF &rect, QGraphicsItem *parent)
       QGraphicsEllipseItem(rect, parent),
       m_edge_mode(false),
       m_edges(0),
-      m_neighbors(0)
+      m_neighbors(0),
+      m_index(-1)
 {
     init();
 }
@@ -15,7 +16,8 @@ Node::Node(qreal x, qreal y, qreal w, qreal h, QGraphicsItem *parent)
       QGraphicsEllipseItem(x, y, w, h, parent),
       m_edge_mode(false),
       m_edges(0),
-      m_neighbors(0)
+      m_neighbors(0),
+      m_index(-1)
 {
     init();
 }
@@ -25,7 +27,8 @@ Node::Node(QGraphicsItem *parent)
       QGraphicsEllipseItem(parent),
       m_edge_mode(false),
       m_edges(0),
-      m_neighbors(0)
+      m_neighbors(0),
+      m_index(-1)
 {
     init();
 }
@@ -51,7 +54,10 @@ void Node::init()
         LOG_EXIT("Invalid handler", );
 
     if ((name = findValidName()) != -1)
+    {
         m_text = QString::number(name);
+        m_index = name - 1;
+    }
     else
         LOG_EXIT("Invalid name!", );
 
@@ -62,28 +68,12 @@ void Node::init()
 
 int Node::findValidName() const
 {
-    int name;
-    Node *first;
     GraphicsView *view = MainWindow::instance().getView();
-    QVector<Node*> nodes;
 
     if (!view)
         LOG_EXIT("Invalid pointer", -1);
 
-    nodes = view->getNodes();
-
-    if (!(first = view->findNodeByName(1)))
-        return 1;
-
-    name = first->text().toInt();
-
-    while (true)
-    {
-        if (!view->findNodeByName(++name))
-            return name;
-    }
-
-    return -1;
+    return view->nextNodeIndex() + 1;
 }
 
 void Node::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
@@ -167,16 +157,12 @@ void Node::modifyEdgeVertices(Edge *edge, Node *first, Node *second)
 
 Edge *Node::findConnectedEdge(Node *node) const
 {
-    if (!node)
-        LOG_EXIT("Invalid pointer", nullptr);
+    GraphicsView *view = MainWindow::instance().getView();
 
-    for(int i=0; i<m_edges.size(); i++)
-    {
-        if (m_edges[i]->isExist(node))
-            return m_edges[i];
-    }
+    if (!node || !view)
+        LOG_EXIT("Invalid pointer", nullptr);
 
-    return nullptr;
+    return view->findEdge(this, node);
 }
 
 int Node::findEdge(Edge *edge) const
@@ -245,6 +231,22 @@ QString Node::text() const
     return m_text;
 }
 
+void Node::setLabel(const QString label)
+{
+    m_label = label;
+    setToolTip(label);
+}
+
+QString Node::label() const
+{
+    return m_label;
+}
+
+int Node::index() const
+{
+    return m_index;
+}
+
 QVector<Edge *> *Node::getEdges()
 {
     return &m_edges;
@@ -289,6 +291,7 @@ void Node::mousePressEvent(QGraphicsSceneMouseEvent *event)
         /* Add edges and vertices to it */
         this->addEdge(node, this,  &edge);
         node->modifyEdgeVertices(edge, nullptr, this);
+        view->registerEdge(edge);
 
         emit setMode(Mode::Default);
         node->setEdgeSelection(false);
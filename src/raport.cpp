@@ -3,7 +3,12 @@
 
 Raport::Raport(QWidget *parent)
     : AbstractWindow(parent),
-      m_lbl(nullptr)
+      m_lbl(nullptr),
+      m_page_lbl(nullptr),
+      m_page_info(nullptr),
+      m_prev(nullptr),
+      m_next(nullptr),
+      m_page(0)
 {
     layout();
     this->setMinimumWidth(Width);
@@ -19,19 +24,36 @@ Raport::~Raport()
 void Raport::layout()
 {
     QVBoxLayout *layout = new QVBoxLayout;
+    QHBoxLayout *pages = new QHBoxLayout;
 
     layout->setAlignment(Qt::AlignLeft | Qt::AlignTop);
 
     if (createLabel("", QFont("Ubuntu", 10), &m_lbl))
         layout->addWidget(m_lbl);
 
+    if (createLabel("", QFont("Ubuntu", 10), &m_page_lbl))
+        layout->addWidget(m_page_lbl);
+
+    m_prev = new QPushButton("<");
+    m_next = new QPushButton(">");
+    createLabel("", QFont("Ubuntu", 10), &m_page_info);
+    connect(m_prev, SIGNAL(clicked(bool)), this, SLOT(prevPage()));
+    connect(m_next, SIGNAL(clicked(bool)), this, SLOT(nextPage()));
+
+    pages->addWidget(m_prev);
+    pages->addWidget(m_page_info);
+    pages->addWidget(m_next);
+    layout->addLayout(pages);
+
     this->setLayout(layout);
+    clearPages();
 }
 
 void Raport::setRaport(QVector<int> raport)
 {
     size_t counter = 0, limit = 15;
 
+    clearPages();
     m_lbl->setText("Nodes: ");
 
     for(int i=0; i<raport.size(); i++)
@@ -49,6 +71,7 @@ void Raport::setRaport(QVector<int> raport)
 
 void Raport::setRaport(QString msg)
 {
+    clearPages();
     m_lbl->setText(msg);
 }
 
@@ -75,3 +98,119 @@ void Raport::appendRaport(QString msg)
 {
     m_lbl->setText(m_lbl->text() + "<br/>" + msg);
 }
+
+bool Raport::setMatrix(QString filename, QVector<QString> names, int row)
+{
+    clearPages();
+
+    if (!m_matrix.open(filename))
+        LOG_EXIT("Can't open matrix:" << filename, false);
+
+    m_names = names;
+    m_names.resize(m_matrix.size());
+
+    /* XXX: Start from the row of the given source */
+    row = (row < 0 || row >= m_matrix.size()) ? 0 : row;
+    showPage(row * ((m_matrix.size() + PageSize - 1) / PageSize));
+
+    return true;
+}
+
+void Raport::setTable(QVector<QString> lines)
+{
+    clearPages();
+
+    if (lines.isEmpty())
+        LOG_EXIT("Table is empty", );
+
+    m_lines = lines;
+    showPage(0);
+}
+
+void Raport::clearPages()
+{
+    m_matrix.close();
+    m_names.clear();
+    m_lines.clear();
+    m_page = 0;
+
+    m_page_lbl->clear();
+    m_page_lbl->hide();
+    m_page_info->hide();
+    m_prev->hide();
+    m_next->hide();
+}
+
+int Raport::pageCount() const
+{
+    if (!m_matrix.isOpen())
+        return (m_lines.size() + PageSize - 1) / PageSize;
+
+    /* XXX: Every row is split in pages of PageSize destinations */
+    return m_matrix.size() * ((m_matrix.size() + PageSize - 1) / PageSize);
+}
+
+QString Raport::matrixPage(int page)
+{
+    QString result;
+    int per_row, row, begin, end;
+
+    per_row = (m_matrix.size() + PageSize - 1) / PageSize;
+    row = page / per_row;
+    begin = (page % per_row) * PageSize;
+    end = qMin(begin + (int) PageSize, m_matrix.size());
+
+    for(int i=begin; i<end && !m_names[row].isEmpty(); i++)
+    {
+        int distance;
+
+        if (i == row || m_names[i].isEmpty())
+            continue;
+
+        distance = m_matrix.distance(row, i);
+        result += m_names[row] + " - " + m_names[i] + " : " +
+          (distance < 0 ? QString("-") : QString::number(distance)) + "<br/>";
+    }
+
+    return result;
+}
+
+void Raport::showPage(int page)
+{
+    QString result;
+
+    if (page < 0 || page >= pageCount())
+        LOG_EXIT("Invalid page:" << page, );
+
+    if (m_matrix.isOpen())
+        result = matrixPage(page);
+    else
+    {
+        int end = qMin((page + 1) * (int) PageSize, m_lines.size());
+
+        for(int i=page * PageSize; i<end; i++)
+            result += m_lines[i] + "<br/>";
+    }
+
+    m_page_lbl->show();
+    m_page_info->show();
+    m_prev->show();
+    m_next->show();
+
+    m_page = page;
+    m_page_lbl->setText(result);
+    m_page_info->setText(QString("Page %1 of %2").arg(page + 1)
+      .arg(pageCount()));
+    m_prev->setEnabled(page > 0);
+    m_next->setEnabled(page + 1 < pageCount());
+}
+
+void Raport::prevPage()
+{
+    showPage(m_page - 1);
+}
+
+void Raport::nextPage()
+{
+    showPage(m_page + 1);
+}
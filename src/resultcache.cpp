@@ -0,0 +1,72 @@
+#include "resultcache.h"
+
+ResultCache::ResultCache()
+{
+
+}
+
+ResultCache::~ResultCache()
+{
+
+}
+
+bool ResultCache::equal(const cache_key_t &first, const cache_key_t &second)
+{
+    return first.version == second.version && first.start == second.start &&
+      first.finish == second.finish && first.order == second.order &&
+      first.variant == second.variant;
+}
+
+bool ResultCache::find(const cache_key_t &key, algorithm_result_t *result)
+{
+    if (!result)
+        return false;
+
+    for(int i=0; i<m_entries.size(); i++)
+    {
+        if (!equal(m_entries[i].first, key))
+            continue;
+
+        m_entries.move(i, 0);
+        *result = m_entries[0].second;
+
+        return true;
+    }
+
+    return false;
+}
+
+void ResultCache::insert(const cache_key_t &key,
+  const algorithm_result_t &result)
+{
+    for(int i=0; i<m_entries.size(); i++)
+    {
+        if (equal(m_entries[i].first, key))
+        {
+            m_entries.removeAt(i);
+            break;
+        }
+    }
+
+    /* XXX: Entries of older graph versions can't be hit any more */
+    for(int i=m_entries.size() - 1; i>=0; i--)
+    {
+        if (m_entries[i].first.version != key.version)
+            m_entries.removeAt(i);
+    }
+
+    m_entries.prepend(qMakePair(key, result));
+
+    while (m_entries.size() > Capacity)
+        m_entries.removeLast();
+}
+
+void ResultCache::clear()
+{
+    m_entries.clear();
+}
+
+int ResultCache::size() const
+{
+    return m_entries.size();
+}
@@ -1,5 +1,8 @@
 #include "tab.h"
-#include "bfsalgorithm.h"
+#include "mainwindow.h"
+#include "dejikstralgorithm.h"
+#include "astaralgorithm.h"
+#include "graphfile.h"
 
 Tab::Tab(int type, QWidget *parent)
     : QWidget(parent),
@@ -7,7 +10,17 @@ Tab::Tab(int type, QWidget *parent)
       m_storage(nullptr),
       m_settings(nullptr),
       m_little_bit(nullptr),
-      m_biggest_bit(nullptr)
+      m_biggest_bit(nullptr),
+      m_heaps(nullptr),
+      m_bidirectional(nullptr),
+      m_astar_scale(nullptr),
+      m_astar_compare(nullptr),
+      m_budget(nullptr),
+      m_all_pairs(nullptr),
+      m_dynamic(nullptr),
+      m_hierarchy(nullptr),
+      m_landmarks(nullptr),
+      m_landmark_selection(nullptr)
 {
     switch(type)
     {
@@ -46,6 +59,56 @@ QRadioButton *Tab::getBiggestBitRB() const
     return m_biggest_bit;
 }
 
+QComboBox *Tab::getHeapCB() const
+{
+    return m_heaps;
+}
+
+QCheckBox *Tab::getBidirectionalCB() const
+{
+    return m_bidirectional;
+}
+
+QDoubleSpinBox *Tab::getAStarScaleSB() const
+{
+    return m_astar_scale;
+}
+
+QCheckBox *Tab::getAStarCompareCB() const
+{
+    return m_astar_compare;
+}
+
+QSpinBox *Tab::getTimeBudgetSB() const
+{
+    return m_budget;
+}
+
+QCheckBox *Tab::getAllPairsCB() const
+{
+    return m_all_pairs;
+}
+
+QCheckBox *Tab::getDynamicCB() const
+{
+    return m_dynamic;
+}
+
+QCheckBox *Tab::getHierarchyCB() const
+{
+    return m_hierarchy;
+}
+
+QSpinBox *Tab::getLandmarksSB() const
+{
+    return m_landmarks;
+}
+
+QComboBox *Tab::getLandmarkSelectionCB() const
+{
+    return m_landmark_selection;
+}
+
 void Tab::layout()
 {
     QVBoxLayout *layout = new QVBoxLayout;
@@ -69,7 +132,7 @@ QListWidget *Tab::createAlgorithmsTab(QWidget *parent, QListWidget **list)
     QString path = SettingsWindow::pathToImages();
     SettingsWindow *sw = qobject_cast<SettingsWindow*> (this->parent());
 
-    lst << "BFS" << "DFS" << "Dejikstra";
+    lst << "BFS" << "DFS" << "Dejikstra" << "A*";
 
     *list = new QListWidget(parent);
     (*list)->setIconSize(QSize(10, 10));
@@ -100,6 +163,7 @@ QWidget *Tab::createStorageTab(QWidget *parent, QWidget **tab)
     (*tab) = new QWidget(parent);
     layout->addWidget(createPushButton("Upload", SLOT(upload())));
     layout->addWidget(createPushButton("Download", SLOT(download())));
+    layout->addWidget(createPushButton("Batch queries", SLOT(batch())));
     (*tab)->setLayout(layout);
 
     return *tab;
@@ -118,29 +182,110 @@ QPushButton *Tab::createPushButton(QString title, const char *slot)
 QWidget *Tab::createSettingsTab(QWidget *parent, QWidget **settings)
 {
     QVBoxLayout *layout;
+    QHBoxLayout *heap, *scale, *budget, *landmarks;
+    QStringList lst;
 
     *settings = new QWidget(parent);
     layout = new QVBoxLayout;
+    heap = new QHBoxLayout;
+    scale = new QHBoxLayout;
+    budget = new QHBoxLayout;
+    landmarks = new QHBoxLayout;
     m_little_bit = new QRadioButton("From little bit");
     m_biggest_bit = new QRadioButton("From biggest bit");
     m_little_bit->setChecked(true);
 
+    /* XXX: Order should match HeapID enum */
+    lst << "Binary heap" << "Pairing heap" << "Radix heap";
+    m_heaps = new QComboBox;
+    m_heaps->addItems(lst);
+
+    heap->addWidget(new QLabel("Dejikstra queue:"));
+    heap->addWidget(m_heaps);
+
+    /* XXX: BFS and Dejikstra only */
+    m_bidirectional = new QCheckBox("Bidirectional search");
+
+    /* XXX: Dejikstra only, the Raport pages through the matrix file */
+    m_all_pairs = new QCheckBox("All pairs distances");
+
+    /* XXX: Dejikstra only, repairs the last tree after edits. Off by
+     * default, the tree settles every node, a search stops at finish */
+    m_dynamic = new QCheckBox("Keep distance tree (dynamic updates)");
+    m_dynamic->setChecked(false);
+
+    /* XXX: Dejikstra only, also saved next to the graph by Download */
+    m_hierarchy = new QCheckBox("Contraction hierarchy (static graph)");
+
+    /* XXX: A* only, also saved next to the graph by Download. Order of
+     * the selections should match Landmarks::Selection */
+    m_landmarks = new QSpinBox;
+    m_landmarks->setRange(0, Landmarks::MaxCount);
+    m_landmarks->setSpecialValueText("Off");
+    m_landmark_selection = new QComboBox;
+    m_landmark_selection->addItems(QStringList() << "Farthest" <<
+      "Highest degree");
+
+    landmarks->addWidget(new QLabel("A* landmarks:"));
+    landmarks->addWidget(m_landmarks);
+    landmarks->addWidget(m_landmark_selection);
+
+    /* XXX: Multiplies pixel distance between node centers */
+    m_astar_scale = new QDoubleSpinBox;
+    m_astar_scale->setRange(0, 100);
+    m_astar_scale->setDecimals(3);
+    m_astar_scale->setSingleStep(0.1);
+    m_astar_scale->setValue(1.0);
+
+    scale->addWidget(new QLabel("A* heuristic scale:"));
+    scale->addWidget(m_astar_scale);
+
+    /* XXX: A* only, a whole extra Dejikstra run per query */
+    m_astar_compare = new QCheckBox("Compare A* with Dejikstra");
+
+    /* XXX: 0 means the search runs until done or cancelled */
+    m_budget = new QSpinBox;
+    m_budget->setRange(0, 3600000);
+    m_budget->setSingleStep(100);
+    m_budget->setSpecialValueText("No limit");
+
+    budget->addWidget(new QLabel("Time budget, ms:"));
+    budget->addWidget(m_budget);
+
     layout->addWidget(m_little_bit);
     layout->addWidget(m_biggest_bit);
+    layout->addLayout(heap);
+    layout->addWidget(m_bidirectional);
+    layout->addWidget(m_all_pairs);
+    layout->addWidget(m_dynamic);
+    layout->addWidget(m_hierarchy);
+    layout->addLayout(scale);
+    layout->addWidget(m_astar_compare);
+    layout->addLayout(landmarks);
+    layout->addLayout(budget);
     (*settings)->setLayout(layout);
 
     return *settings;
 }
 
-void Tab::writeGraph(QVector<QVector<int> > graph, QTextStream &stream) const
+void Tab::writeGraph(const CSRGraph &graph, QTextStream &stream) const
 {
+    /* XXX: Matrix rows are written straight from the sorted adjacency
+     * rows, no matrix is built */
     for(int i=0; i<graph.size(); i++)
     {
-        for(int j=0; j<graph[i].size(); j++)
+        const int *adj = graph.neighbors(i);
+        const int *weights = graph.weights(i);
+        int k = 0;
+
+        for(int j=0; j<graph.size(); j++)
         {
-            stream << graph[i][j];
+            if (k < graph.degree(i) && adj[k] == j)
+                stream << weights[k++];
+            else
+                stream << 0;
 
-            if (j < graph[i].size() - 1)
+            if (j < graph.size() - 1)
                 stream << " ";
         }
 
@@ -202,39 +347,225 @@ void Tab::readUIConf(QString filename, QTextStream &stream) const
 
         node = view->addNode(radius, QBrush(Qt::white, Qt::SolidPattern),
          point);
-        node->setToolTip(tooltips[i++]);
+        node->setLabel(tooltips[i++]);
     }
 }
 
-void Tab::readGraph(QString filename) const
+void Tab::readText(QString filename, GraphText::Format format) const
 {
+    QFile file;
     QTextStream stream;
-    QVector<QVector<int> > graph;
-    QFile file(filename);
+    GraphText text;
     GraphicsView *view = MainWindow::instance().getView();
 
     if (!view)
         LOG_EXIT("Invalid pointer", );
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        LOG_EXIT("Can't open file!", );
+    /* XXX: Parsed first, a broken file leaves the canvas alone */
+    if (!text.read(filename, format))
+    {
+        MainWindow::instance().showMessage(
+          QString("Invalid graph file, line %1!").arg(text.errorLine()));
+        LOG_EXIT("Can't read file: " << filename, );
+    }
 
-    stream.setDevice(&file);
+    file.setFileName(filename.split(".")[0] + ".conf");
 
-    while(!stream.atEnd())
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
-        QVector<int> temp;
-        QString line = stream.readLine();
-        QStringList list = line.split(" ");
+        stream.setDevice(&file);
+        readUIConf(filename, stream);
+        file.close();
+    }
+    else if (format == GraphText::EdgeList)
+    {
+        placeNodes(text.size());
+    }
+    else
+    {
+        LOG_EXIT("Can't open file!: " << filename, );
+    }
 
-        for(int i=0; i<list.size(); i++)
-            temp.push_back(list[i].toInt());
+    view->restoreEdges(text.graph());
+}
+
+void Tab::importGraph(QString filename, GraphText::Format format)
+{
+    GraphText text;
+    QMessageBox::StandardButton layout;
+    GraphicsView *view = MainWindow::instance().getView();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
 
-        graph.push_back(temp);
+    if (!text.read(filename, format))
+    {
+        MainWindow::instance().showMessage(
+          QString("Invalid graph file, line %1!").arg(text.errorLine()));
+        LOG_EXIT("Can't read file: " << filename, );
     }
 
-    file.close();
-    view->restoreEdges(graph);
+    /* XXX: A node item per vertex is what makes big graphs slow, without
+     * them the graph is there for batch queries */
+    layout = QMessageBox::question(this, "Import",
+      QString("%1 nodes, %2 arcs. Put them on the canvas? Otherwise the "
+        "graph is there for batch queries only.").arg(text.size())
+        .arg(text.arcCount()), QMessageBox::Yes | QMessageBox::No,
+      text.size() <= LayoutLimit ? QMessageBox::Yes : QMessageBox::No);
+
+    if (layout == QMessageBox::Yes)
+    {
+        view->deleteAll();
+        placeNodes(text.size());
+        view->restoreEdges(text.graph());
+    }
+    else
+    {
+        view->loadGraph(text.graph());
+    }
+}
+
+void Tab::placeNodes(int count) const
+{
+    GraphicsView *view = MainWindow::instance().getView();
+    size_t radius = 20;
+    int step = 2 * radius, columns;
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    /* XXX: Edge lists have no layout, a grid row by row keeps nodes apart */
+    columns = qMax(1, view->width() / step);
+
+    for(int i=0; i<count; i++)
+    {
+        QPointF point(step * (i % columns) + radius,
+          step * (i / columns) + radius);
+
+        if (!view->addNode(radius, QBrush(Qt::white, Qt::SolidPattern), point))
+            LOG_EXIT("Can't add node: " << i, );
+    }
+}
+
+void Tab::writeBinary(QString filename) const
+{
+    GraphFile file;
+    QBuffer hierarchy, landmarks;
+    QVector<QString> labels;
+    QVector<Node*> nodes;
+    const CSRGraph *graph = nullptr;
+    DejikstraAlgorithm *dejikstra;
+    AStarAlgorithm *astar;
+    GraphicsView *view = MainWindow::instance().getView();
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    nodes = view->getNodes();
+    labels.resize(view->getModel().capacity());
+
+    for(int i=0; i<nodes.size(); i++)
+        labels[nodes[i]->index()] = nodes[i]->label();
+
+    if (!file.create(filename) || !file.writeGraph(view->getModel(), labels))
+    {
+        file.cancel();
+        MainWindow::instance().showMessage("Can't save graph!");
+        return;
+    }
+
+    /* XXX: Preprocessing goes in as sections, one file to copy around.
+     * Holes of deleted nodes are gone from TOPO, so the kept data of the
+     * model graph would match nothing read back */
+    if (view->getModel().capacity() != view->getModel().nodeCount())
+        graph = &file.writtenGraph();
+
+    if ((dejikstra = hierarchyToSave()))
+    {
+        hierarchy.open(QIODevice::WriteOnly);
+
+        if (!dejikstra->saveHierarchy(&hierarchy, graph) ||
+             !file.writeSection(GRAPH_SECTION_HIERARCHY, hierarchy.data()))
+        {
+            MainWindow::instance().showMessage("Can't save hierarchy!");
+        }
+
+        hierarchy.close();
+    }
+
+    if ((astar = landmarksToSave()))
+    {
+        landmarks.open(QIODevice::WriteOnly);
+
+        if (!astar->saveLandmarks(&landmarks, graph) ||
+             !file.writeSection(GRAPH_SECTION_LANDMARKS, landmarks.data()))
+        {
+            MainWindow::instance().showMessage("Can't save landmarks!");
+        }
+
+        landmarks.close();
+    }
+
+    if (!file.commit())
+        MainWindow::instance().showMessage("Can't save graph!");
+}
+
+void Tab::readBinary(QString filename) const
+{
+    GraphFile file;
+    QByteArray data;
+    QBuffer buffer;
+    DejikstraAlgorithm *dejikstra;
+    AStarAlgorithm *astar;
+    GraphicsView *view = MainWindow::instance().getView();
+    size_t radius = 20;
+
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
+
+    if (!file.open(filename))
+    {
+        MainWindow::instance().showMessage("Invalid graph file!");
+        LOG_EXIT("Can't read file: " << filename, );
+    }
+
+    /* XXX: Positions and labels are in the file, no .conf files */
+    for(int i=0; i<file.size(); i++)
+    {
+        Node *node = view->addNode(radius, QBrush(Qt::white, Qt::SolidPattern),
+          file.position(i));
+
+        if (!node)
+            LOG_EXIT("Can't add node: " << i, );
+
+        node->setLabel(file.label(i));
+    }
+
+    view->restoreEdges(file.graph());
+
+    /* XXX: Sections are read in place, a stale one is rejected and the
+     * next run builds */
+    if (file.hasSection(GRAPH_SECTION_HIERARCHY) && (dejikstra =
+         qobject_cast<DejikstraAlgorithm*>(
+           MainWindow::instance().getAlgorithm(Dejikstra))))
+    {
+        data = file.section(GRAPH_SECTION_HIERARCHY);
+        buffer.setBuffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        dejikstra->loadHierarchy(&buffer);
+        buffer.close();
+    }
+
+    if (file.hasSection(GRAPH_SECTION_LANDMARKS) && (astar =
+         qobject_cast<AStarAlgorithm*>(
+           MainWindow::instance().getAlgorithm(AStar))))
+    {
+        data = file.section(GRAPH_SECTION_LANDMARKS);
+        buffer.setBuffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        astar->loadLandmarks(&buffer);
+        buffer.close();
+    }
 }
 
 void Tab::writeNodeToolTips(QString filename) const
@@ -257,11 +588,9 @@ void Tab::writeNodeToolTips(QString filename) const
 
     for(int i=0; i<nodes.size(); i++)
     {
-        QString tooltip = !nodes[i]->toolTip().isEmpty() ?
-          nodes[i]->toolTip() : "";
-
+        /* XXX: The label, a distance in the tooltip is no part of it */
         stream << nodes[i]->text() << " "
-          << tooltip << "\n";
+          << nodes[i]->label() << "\n";
     }
 
     file.close();
@@ -298,53 +627,191 @@ QVector<QString> Tab::readNodeToolTips(QString filename) const
 void Tab::download()
 {
     QFile file;
-    QString filename;
+    QString filename, filter;
     QTextStream stream;
-    QVector<QVector<int> > graph;
-    /* XXX: used only for accessing to initGraph() method. Not correct logic */
-    BFSAlgorithm algorithm;
+    GraphicsView *view = MainWindow::instance().getView();
 
-    algorithm.initGraph();
-    graph = algorithm.getGraph();
+    if (!view)
+        LOG_EXIT("Invalid pointer", );
 
-    if (graph.isEmpty())
+    if (!view->getModel().nodeCount())
         LOG_EXIT("Canvas is empty!", );
 
-    filename = QFileDialog::getSaveFileName(this, "Save file...", "", "*.txt");
+    filename = QFileDialog::getSaveFileName(this, "Save file...", "",
+      "Graph (*.g2d);;Text matrix (*.txt);;Edge list (*.edges)", &filter);
 
     if (filename.isEmpty())
         LOG_EXIT("Filename is empty", );
 
-    file.setFileName(filename + ".txt");
+    /* XXX: The base name, Upload finds the rest of the files by it */
+    filename = filename.split(".")[0];
 
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-        LOG_EXIT("Can't open file!", );
+    /* XXX: The container holds the graph, layout, labels and the
+     * preprocessing. The text formats are for export only, the graph
+     * and its .conf files, nothing precomputed */
+    if (filter.contains("txt"))
+    {
+        file.setFileName(filename + ".txt");
 
-    stream.setDevice(&file);
-    writeGraph(graph, stream);
-    file.close();
-    writeUIConf(filename);
-    writeNodeToolTips(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+            LOG_EXIT("Can't open file!", );
+
+        stream.setDevice(&file);
+        writeGraph(view->getModel().graph(), stream);
+        file.close();
+        writeUIConf(filename);
+        writeNodeToolTips(filename);
+    }
+    else if (filter.contains("edges"))
+    {
+        if (!GraphText::writeEdgeList(filename + ".edges",
+               view->getModel().graph()))
+        {
+            MainWindow::instance().showMessage("Can't save graph!");
+        }
+
+        writeUIConf(filename);
+        writeNodeToolTips(filename);
+    }
+    else
+        writeBinary(filename + ".g2d");
 }
 
 void Tab::upload()
+{
+    QString filename, filter;
+    GraphicsView *view;
+
+    filename = QFileDialog::getOpenFileName(this, "Open file...", "",
+      "Graphs (*.g2d *.txt *.edges);;DIMACS (*.gr);;METIS (*.graph *.metis);;"
+      "Matrix Market (*.mtx);;SNAP (*.txt *.snap)", &filter);
+
+    if (filename.isEmpty())
+        LOG_EXIT("Filename is empty", );
+
+    /* XXX: A headless graph owns all ids, uploaded nodes would collide */
+    if ((view = MainWindow::instance().getView()) && view->isHeadless())
+        view->deleteAll();
+
+    /* XXX: SNAP files are .txt too, the filter tells them apart */
+    if (filter.startsWith("DIMACS"))
+        importGraph(filename, GraphText::Dimacs);
+    else if (filter.startsWith("METIS"))
+        importGraph(filename, GraphText::Metis);
+    else if (filter.startsWith("Matrix Market"))
+        importGraph(filename, GraphText::MatrixMarket);
+    else if (filter.startsWith("SNAP"))
+        importGraph(filename, GraphText::Snap);
+    else if (filename.endsWith(".g2d"))
+    {
+        readBinary(filename);
+        return;
+    }
+    else if (filename.endsWith(".edges"))
+        readText(filename, GraphText::EdgeList);
+    else
+        readText(filename, GraphText::Matrix);
+
+    /* XXX: Files saved before the container kept these next to the graph */
+    readPreprocessing(filename.split(".")[0]);
+}
+
+Tab *Tab::settingsTab() const
+{
+    SettingsWindow *settings = MainWindow::instance().getSettingsWindow();
+
+    return settings ? settings->getSettingsTab() : nullptr;
+}
+
+DejikstraAlgorithm *Tab::hierarchyToSave() const
+{
+    Tab *settings = settingsTab();
+
+    if (!settings || !settings->getHierarchyCB()->isChecked())
+        return nullptr;
+
+    return qobject_cast<DejikstraAlgorithm*>(
+      MainWindow::instance().getAlgorithm(Dejikstra));
+}
+
+AStarAlgorithm *Tab::landmarksToSave() const
+{
+    Tab *settings = settingsTab();
+    AStarAlgorithm *astar;
+
+    if (!settings || !settings->getLandmarksSB()->value() || !(astar =
+         qobject_cast<AStarAlgorithm*>(
+           MainWindow::instance().getAlgorithm(AStar))))
+    {
+        return nullptr;
+    }
+
+    astar->setLandmarks(settings->getLandmarksSB()->value(),
+      (Landmarks::Selection) settings->getLandmarkSelectionCB()->currentIndex());
+
+    return astar;
+}
+
+void Tab::readPreprocessing(QString filename) const
+{
+    QFile file;
+    DejikstraAlgorithm *dejikstra;
+    AStarAlgorithm *astar;
+
+    /* XXX: Optional, a missing or stale one is built by the next run */
+    file.setFileName(filename + ".ch");
+
+    if (file.exists() && (dejikstra =
+         qobject_cast<DejikstraAlgorithm*>(
+           MainWindow::instance().getAlgorithm(Dejikstra))) &&
+         file.open(QIODevice::ReadOnly))
+    {
+        dejikstra->loadHierarchy(&file);
+        file.close();
+    }
+
+    file.setFileName(filename + ".lmk");
+
+    if (file.exists() && (astar =
+         qobject_cast<AStarAlgorithm*>(
+           MainWindow::instance().getAlgorithm(AStar))) &&
+         file.open(QIODevice::ReadOnly))
+    {
+        astar->loadLandmarks(&file);
+        file.close();
+    }
+}
+
+void Tab::batch()
 {
     QFile file;
-    QString filename;
+    QString filename, queries;
     QTextStream stream;
+    bool ok = true;
 
-    filename = QFileDialog::getOpenFileName(this, "Open file...", "", "*.txt");
+    filename = QFileDialog::getOpenFileName(this, "Open queries...", "",
+      "*.txt");
 
+    /* XXX: No file - pairs are typed in */
     if (filename.isEmpty())
-        LOG_EXIT("Filename is empty", );
+    {
+        queries = MainWindow::instance().openInputDialog("Batch queries",
+          "Pairs \"start finish\" separated by \",\":", &ok);
+    }
+    else
+    {
+        file.setFileName(filename);
 
-    file.setFileName(filename.split(".")[0] + ".conf");
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            LOG_EXIT("Can't open file!: " << filename, );
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        LOG_EXIT("Can't open file!: " << filename, );
+        stream.setDevice(&file);
+        queries = stream.readAll();
+        file.close();
+    }
 
-    stream.setDevice(&file);
-    readUIConf(filename, stream);
-    file.close();
-    readGraph(filename);
+    if (!ok || queries.isEmpty())
+        LOG_EXIT("Queries are empty", );
+
+    MainWindow::instance().runBatch(queries);
 }
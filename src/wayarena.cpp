@@ -0,0 +1,75 @@
+#include <algorithm>
+
+#include "wayarena.h"
+
+WayArena::WayArena()
+    : m_nodes(0),
+      m_offsets(1, 0)
+{
+
+}
+
+WayArena::~WayArena()
+{
+
+}
+
+void WayArena::clear()
+{
+    m_nodes.clear();
+    m_offsets.resize(1);
+}
+
+int WayArena::size() const
+{
+    return m_offsets.size() - 1;
+}
+
+bool WayArena::isEmpty() const
+{
+    return !size();
+}
+
+void WayArena::openWay()
+{
+    dropWay();
+}
+
+void WayArena::pushNode(int node)
+{
+    m_nodes.push_back(node);
+}
+
+void WayArena::reverseOpenWay()
+{
+    std::reverse(m_nodes.begin() + m_offsets.back(), m_nodes.end());
+}
+
+void WayArena::closeWay()
+{
+    m_offsets.push_back(m_nodes.size());
+}
+
+void WayArena::dropWay()
+{
+    m_nodes.resize(m_offsets.back());
+}
+
+int WayArena::length(int way) const
+{
+    return m_offsets[way + 1] - m_offsets[way];
+}
+
+const int *WayArena::nodes(int way) const
+{
+    return m_nodes.constData() + m_offsets[way];
+}
+
+QVector<int> WayArena::way(int way) const
+{
+    QVector<int> result(length(way));
+
+    std::copy(nodes(way), nodes(way) + length(way), result.begin());
+
+    return result;
+}